@@ -0,0 +1,25 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class LockOnTargetMass : ModuleRules
+{
+    public LockOnTargetMass(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        PublicDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "Core",
+                "CoreUObject",
+                "Engine",
+                "LockOnTarget",
+                "MassEntity",
+                "MassCommon",
+                "MassActors",
+                "MassSpawner",
+            }
+            );
+    }
+}
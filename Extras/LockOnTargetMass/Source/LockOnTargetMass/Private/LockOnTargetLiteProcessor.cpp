@@ -0,0 +1,207 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#include "LockOnTargetLiteProcessor.h"
+#include "LockOnTargetMassTypes.h"
+#include "TargetComponent.h"
+#include "TargetManager.h"
+#include "LockOnTargetDefines.h"
+
+#include "MassActorSubsystem.h"
+#include "MassCommonFragments.h"
+#include "MassExecutionContext.h"
+#include "Engine/World.h"
+
+ULockOnTargetLiteProcessor::ULockOnTargetLiteProcessor()
+	: EntityQuery(*this)
+{
+	bAutoRegisterWithProcessingPhases = true;
+	ProcessingPhase = EMassProcessingPhase::PrePhysics;
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::Server | EProcessorExecutionFlags::Standalone);
+
+	//UTargetManager isn't thread safe.
+	bRequiresGameThreadExecution = true;
+}
+
+void ULockOnTargetLiteProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FLockOnTargetLiteFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FMassActorFragment>(EMassFragmentAccess::ReadOnly, EMassFragmentPresence::Optional);
+	EntityQuery.AddConstSharedRequirement<FLockOnTargetLiteParams>(EMassFragmentPresence::All);
+}
+
+void ULockOnTargetLiteProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	LOT_SCOPED_EVENT(LockOnTargetLiteProcessor);
+
+	UWorld* const World = EntityManager.GetWorld();
+	UTargetManager* const TargetManager = World ? World->GetSubsystem<UTargetManager>() : nullptr;
+
+	if (!TargetManager)
+	{
+		return;
+	}
+
+	const double Time = World->GetTimeSeconds();
+
+	EntityQuery.ForEachEntityChunk(EntityManager, Context, [this, TargetManager, Time](FMassExecutionContext& Context)
+		{
+			const FLockOnTargetLiteParams& Params = Context.GetConstSharedFragment<FLockOnTargetLiteParams>();
+			const TConstArrayView<FTransformFragment> Transforms = Context.GetFragmentView<FTransformFragment>();
+			const TArrayView<FLockOnTargetLiteFragment> Fragments = Context.GetMutableFragmentView<FLockOnTargetLiteFragment>();
+
+			//Empty for agents without an actor.
+			const TConstArrayView<FMassActorFragment> Actors = Context.GetFragmentView<FMassActorFragment>();
+
+			for (int32 EntityIndex = 0; EntityIndex < Context.GetNumEntities(); ++EntityIndex)
+			{
+				FLockOnTargetLiteFragment& Fragment = Fragments[EntityIndex];
+
+				//New agents are spread over the interval, so agents spawned together don't search within the same frame.
+				if (Fragment.NextUpdateTime <= 0.0)
+				{
+					Fragment.NextUpdateTime = Time + FMath::FRandRange(0.0, Params.UpdateInterval);
+				}
+				else if (Time >= Fragment.NextUpdateTime)
+				{
+					const AActor* const AgentActor = Actors.IsEmpty() ? nullptr : Actors[EntityIndex].Get();
+					FindTarget(*TargetManager, Params, Transforms[EntityIndex].GetTransform(), AgentActor, Fragment);
+					Fragment.NextUpdateTime = Time + Params.UpdateInterval;
+				}
+
+				if (Fragment.Target.IsValid())
+				{
+					const int32 TargetIndex = TargetManager->GetTargetIndex(Fragment.Target.Get());
+					const FRegisteredTargetsData& RegisteredTargetsData = TargetManager->GetTargetsData();
+
+					if (TargetIndex != INDEX_NONE && RegisteredTargetsData.CanBeCaptured[TargetIndex] && Fragment.SocketIndex < RegisteredTargetsData.SocketsNum[TargetIndex])
+					{
+						//Socket locations are shared with other agents and instigators within the frame.
+						Fragment.TargetLocation = TargetManager->GetSocketLocation(TargetIndex, Fragment.SocketIndex);
+					}
+					else
+					{
+						//The Target has become invalid, so a new one is searched right away.
+						Fragment = FLockOnTargetLiteFragment();
+						Fragment.NextUpdateTime = Time;
+					}
+				}
+			}
+		});
+}
+
+void ULockOnTargetLiteProcessor::FindTarget(UTargetManager& TargetManager, const FLockOnTargetLiteParams& Params, const FTransform& Transform, const AActor* AgentActor, FLockOnTargetLiteFragment& Fragment)
+{
+	const FVector ViewLocation = Transform.GetLocation();
+	const FVector ViewDirection = Transform.GetUnitAxis(EAxis::X);
+
+	Candidates.Reset();
+	TargetManager.QueryTargetIndicesInCaptureRadius(ViewLocation, Params.DefaultCaptureRadius, 1.f, Candidates);
+
+	const FRegisteredTargetsData& RegisteredTargetsData = TargetManager.GetTargetsData();
+	const float MinViewConeDot = FMath::Cos(FMath::DegreesToRadians(Params.ViewConeAngle));
+	const float NearClipRadiusSq = FMath::Square(Params.NearClipRadius);
+
+	TargetsData.Reset();
+	TArray<int32, TInlineAllocator<16>> SocketIndices;
+
+	for (const int32 Index : Candidates)
+	{
+		//The agent own Targets are skipped explicitly, as the near clip radius doesn't cover Sockets placed away from the agent, e.g. on a long weapon.
+		if (!RegisteredTargetsData.CanBeCaptured[Index] || (AgentActor && RegisteredTargetsData.Owners[Index] == AgentActor))
+		{
+			continue;
+		}
+
+		for (int32 SocketIndex = 0; SocketIndex < RegisteredTargetsData.SocketsNum[Index]; ++SocketIndex)
+		{
+			const FVector& Location = TargetManager.GetSocketLocation(Index, SocketIndex);
+			const FVector Delta = Location - ViewLocation;
+			const float DistanceSq = Delta.SizeSquared();
+
+			if (DistanceSq < NearClipRadiusSq)
+			{
+				continue;
+			}
+
+			const FVector Direction = Delta * FMath::InvSqrt(DistanceSq);
+
+			if ((Direction | ViewDirection) < MinViewConeDot)
+			{
+				continue;
+			}
+
+			//The Socket name isn't needed for the weight, so the Target component isn't touched.
+			FTargetContext& TargetContext = TargetsData.AddDefaulted_GetRef();
+			TargetContext.Target.TargetComponent = RegisteredTargetsData.Targets[Index];
+			TargetContext.Location = Location;
+			TargetContext.Direction = Direction;
+			TargetContext.DistanceSq = DistanceSq;
+			TargetContext.Priority = RegisteredTargetsData.Priorities[Index];
+			SocketIndices.Add(SocketIndex);
+		}
+	}
+
+	if (TargetsData.IsEmpty())
+	{
+		if (!CanKeepTarget(TargetManager, Params, ViewLocation, AgentActor, Fragment))
+		{
+			Fragment.Target.Reset();
+			Fragment.Weight = TNumericLimits<float>::Max();
+		}
+
+		return;
+	}
+
+	Params.MakeSolverParams(ViewDirection).Solve(TargetsData);
+
+	int32 BestIndex = 0;
+	int32 HeldIndex = INDEX_NONE;
+
+	for (int32 i = 0; i < TargetsData.Num(); ++i)
+	{
+		if (TargetsData[i].Weight < TargetsData[BestIndex].Weight)
+		{
+			BestIndex = i;
+		}
+
+		if (TargetsData[i].Target.TargetComponent == Fragment.Target.Get() && SocketIndices[i] == Fragment.SocketIndex)
+		{
+			HeldIndex = i;
+		}
+	}
+
+	//The held Target is kept unless another one is better by the margin, so close candidates don't make the agent flicker between them.
+	if (HeldIndex != INDEX_NONE && TargetsData[HeldIndex].Weight * (1.f - Params.SwitchWeightMargin) <= TargetsData[BestIndex].Weight)
+	{
+		BestIndex = HeldIndex;
+	}
+
+	const FTargetContext& BestTarget = TargetsData[BestIndex];
+	Fragment.Target = BestTarget.Target.TargetComponent;
+	Fragment.SocketIndex = SocketIndices[BestIndex];
+	Fragment.TargetLocation = BestTarget.Location;
+	Fragment.Weight = BestTarget.Weight;
+}
+
+bool ULockOnTargetLiteProcessor::CanKeepTarget(UTargetManager& TargetManager, const FLockOnTargetLiteParams& Params, const FVector& ViewLocation, const AActor* AgentActor, const FLockOnTargetLiteFragment& Fragment) const
+{
+	if (!Fragment.Target.IsValid())
+	{
+		return false;
+	}
+
+	const int32 TargetIndex = TargetManager.GetTargetIndex(Fragment.Target.Get());
+
+	if (TargetIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FRegisteredTargetsData& RegisteredTargetsData = TargetManager.GetTargetsData();
+	const float CaptureRadius = RegisteredTargetsData.CaptureRadii[TargetIndex] < 0.f ? Params.DefaultCaptureRadius : RegisteredTargetsData.CaptureRadii[TargetIndex];
+
+	return RegisteredTargetsData.CanBeCaptured[TargetIndex]
+		&& (!AgentActor || RegisteredTargetsData.Owners[TargetIndex] != AgentActor)
+		&& FVector::DistSquared(ViewLocation, RegisteredTargetsData.Locations[TargetIndex]) <= FMath::Square(CaptureRadius * Params.LostRadiusScale);
+}
@@ -0,0 +1,31 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#include "LockOnTargetMassTypes.h"
+
+FWeightedTargetSolverParams FLockOnTargetLiteParams::MakeSolverParams(const FVector& ViewDirection) const
+{
+	FWeightedTargetSolverParams Params;
+	Params.SolverViewDirection = FVector3f(ViewDirection);
+	Params.MinimumFactorThreshold = MinimumFactorThreshold;
+	Params.InvDistanceMaxFactorSq = 1.f / FMath::Max(FMath::Square(DistanceMaxFactor), UE_KINDA_SMALL_NUMBER);
+	Params.InvDeltaAngleMaxFactor = 1.f / FMath::Max(DeltaAngleMaxFactor, UE_KINDA_SMALL_NUMBER);
+
+	//There is no player input, so PlayerInputWeight doesn't take part in the sum.
+	const float WeightSum = DistanceWeight + DeltaAngleWeight + TargetPriorityWeight;
+
+	if (!FMath::IsNearlyZero(WeightSum))
+	{
+		const float WeightNormalizer = PureDefaultWeight / WeightSum;
+
+		auto GetFactorScale = [WeightNormalizer](float Weight)
+			{
+				return Weight > UE_KINDA_SMALL_NUMBER ? Weight * WeightNormalizer : 0.f;
+			};
+
+		Params.DistanceScale = GetFactorScale(DistanceWeight);
+		Params.DeltaAngleScale = GetFactorScale(DeltaAngleWeight);
+		Params.PriorityScale = GetFactorScale(TargetPriorityWeight);
+	}
+
+	return Params;
+}
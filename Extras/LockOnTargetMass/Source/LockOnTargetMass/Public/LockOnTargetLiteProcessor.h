@@ -0,0 +1,50 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "TargetHandlers/WeightedTargetHandler.h"
+#include "LockOnTargetLiteProcessor.generated.h"
+
+class AActor;
+class UTargetManager;
+struct FLockOnTargetLiteFragment;
+struct FLockOnTargetLiteParams;
+
+/**
+ * Finds Targets for Mass agents with FLockOnTargetLiteFragment.
+ * Agents are processed in chunks against the packed data of UTargetManager and weighted by FWeightedTargetSolverParams.
+ * Socket locations are read from the Target components, which cache them per frame. Searches are time-sliced by FLockOnTargetLiteParams::UpdateInterval.
+ * Agents backed by an actor never capture the Targets of that actor.
+ */
+UCLASS()
+class LOCKONTARGETMASS_API ULockOnTargetLiteProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+
+	ULockOnTargetLiteProcessor();
+
+private:
+
+	FMassEntityQuery EntityQuery;
+
+	//Reused by all agents within the frame.
+	TArray<int32> Candidates;
+	TArray<FTargetContext> TargetsData;
+
+private:
+
+	void FindTarget(UTargetManager& TargetManager, const FLockOnTargetLiteParams& Params, const FTransform& Transform, const AActor* AgentActor, FLockOnTargetLiteFragment& Fragment);
+
+	//Whether the captured Target is still within its lost radius.
+	bool CanKeepTarget(UTargetManager& TargetManager, const FLockOnTargetLiteParams& Params, const FVector& ViewLocation, const AActor* AgentActor, const FLockOnTargetLiteFragment& Fragment) const;
+
+protected: /** Overrides */
+
+	//UMassProcessor
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+};
@@ -0,0 +1,28 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTraitBase.h"
+#include "LockOnTargetMassTypes.h"
+#include "LockOnTargetLiteTrait.generated.h"
+
+/**
+ * Gives Mass agents the ability to capture Targets registered in UTargetManager, without LockOnTargetComponent and its Extensions.
+ * Targets are found by ULockOnTargetLiteProcessor using the WeightedTargetHandler weighting.
+ */
+UCLASS(meta = (DisplayName = "LockOnTarget Lite"))
+class LOCKONTARGETMASS_API ULockOnTargetLiteTrait : public UMassEntityTraitBase
+{
+	GENERATED_BODY()
+
+protected:
+
+	UPROPERTY(EditAnywhere, Category = "LockOnTarget")
+	FLockOnTargetLiteParams Params;
+
+protected: /** Overrides */
+
+	//UMassEntityTraitBase
+	virtual void BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, const UWorld& World) const override;
+};
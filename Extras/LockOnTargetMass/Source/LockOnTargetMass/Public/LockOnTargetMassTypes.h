@@ -0,0 +1,110 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "TargetHandlers/WeightedTargetHandler.h"
+#include "LockOnTargetMassTypes.generated.h"
+
+class UTargetComponent;
+
+/**
+ * The Target a Mass agent faces. A lightweight alternative to ULockOnTargetComponent without per-agent UObjects.
+ * Written by ULockOnTargetLiteProcessor.
+ */
+USTRUCT()
+struct LOCKONTARGETMASS_API FLockOnTargetLiteFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+public:
+
+	//The captured Target. Null if none.
+	TWeakObjectPtr<UTargetComponent> Target;
+
+	//The index of the captured Socket in UTargetComponent::GetSockets().
+	int32 SocketIndex = 0;
+
+	//World location of the captured Socket. Refreshed each frame.
+	FVector TargetLocation = FVector::ZeroVector;
+
+	//The weight the Target was captured with.
+	float Weight = TNumericLimits<float>::Max();
+
+	//World time of the next Target search.
+	double NextUpdateTime = 0.0;
+
+public:
+
+	bool IsTargetLocked() const { return Target.IsValid(); }
+};
+
+/**
+ * Targeting settings shared by Mass agents of the same config. A subset of the UWeightedTargetHandler settings with the same meaning.
+ */
+USTRUCT()
+struct LOCKONTARGETMASS_API FLockOnTargetLiteParams : public FMassConstSharedFragment
+{
+	GENERATED_BODY()
+
+public: /** Weights */
+
+	UPROPERTY(EditAnywhere, Category = "Weights", meta = (ClampMin = 0.f, ClampMax = 1.f))
+	float DistanceWeight = 0.725f;
+
+	UPROPERTY(EditAnywhere, Category = "Weights", meta = (ClampMin = 0.f, ClampMax = 1.f))
+	float DeltaAngleWeight = 0.275f;
+
+	UPROPERTY(EditAnywhere, Category = "Weights", meta = (ClampMin = 0.f, ClampMax = 1.f))
+	float TargetPriorityWeight = 0.25f;
+
+	UPROPERTY(EditAnywhere, Category = "Weights", meta = (ClampMin = 0.f))
+	float PureDefaultWeight = 1000.f;
+
+	UPROPERTY(EditAnywhere, Category = "Weights", meta = (ClampMin = 1.f, Units = "cm"))
+	float DistanceMaxFactor = 2420.f;
+
+	UPROPERTY(EditAnywhere, Category = "Weights", meta = (ClampMin = 1.f, ClampMax = 180.f, Units = "Deg"))
+	float DeltaAngleMaxFactor = 45.f;
+
+	UPROPERTY(EditAnywhere, Category = "Weights", meta = (ClampMin = 0.f, ClampMax = 1.f))
+	float MinimumFactorThreshold = 0.035f;
+
+public: /** Sampling */
+
+	/** Targets without a custom capture radius use this one. */
+	UPROPERTY(EditAnywhere, Category = "Sampling", meta = (ClampMin = 0.f, Units = "cm"))
+	float DefaultCaptureRadius = 2200.f;
+
+	/**
+	 * The captured Target is kept within the capture radius multiplied by this scale, but only if no other Target is found.
+	 * Otherwise it's replaced once it leaves the view cone or the capture radius, as it's no longer a candidate.
+	 */
+	UPROPERTY(EditAnywhere, Category = "Sampling", meta = (ClampMin = 1.f, Units = "x"))
+	float LostRadiusScale = 1.1f;
+
+	/**
+	 * The captured Target is replaced by another candidate only if the candidate weight is lower by this fraction of the captured Target weight.
+	 * Prevents switching between candidates of similar weights on each search.
+	 */
+	UPROPERTY(EditAnywhere, Category = "Sampling", meta = (ClampMin = 0.f, ClampMax = 1.f, Units = "x"))
+	float SwitchWeightMargin = 0.15f;
+
+	/** Targets closer than this are ignored. The own Targets of actor-backed agents are always ignored. */
+	UPROPERTY(EditAnywhere, Category = "Sampling", meta = (ClampMin = 0.f, Units = "cm"))
+	float NearClipRadius = 50.f;
+
+	/** The half angle of the cone relative to the agent forward direction within which the Target must be. */
+	UPROPERTY(EditAnywhere, Category = "Sampling", meta = (ClampMin = 0.f, ClampMax = 180.f, Units = "Deg"))
+	float ViewConeAngle = 60.f;
+
+	/** How often each agent searches for a Target. Searches of agents are staggered within the interval. */
+	UPROPERTY(EditAnywhere, Category = "Sampling", meta = (ClampMin = 0.f, Units = "s"))
+	float UpdateInterval = 0.25f;
+
+public:
+
+	//Mirrors UWeightedTargetHandler::MakeSolverParams() without the player input factor.
+	FWeightedTargetSolverParams MakeSolverParams(const FVector& ViewDirection) const;
+};
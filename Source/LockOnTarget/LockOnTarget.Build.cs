@@ -26,6 +26,8 @@ public class LockOnTarget : ModuleRules
                 "Core",
                 "CoreUObject",
                 "Engine",
+                //FLockOnTargetReplayStream is a fast array.
+                "NetCore",
 
             }
 			);
@@ -37,10 +39,14 @@ public class LockOnTarget : ModuleRules
 				//"SlateCore",
 				"UMG",
 				"Projects",
-				"NetCore",
 				"TraceLog",
+				//The private FTargetInfoNetSerializerConfig derives from FNetSerializerConfig even if Iris is disabled.
+				"IrisCore",
 
             }
 			);
+
+		//Defines UE_WITH_IRIS depending on whether the target uses Iris.
+		SetupIrisSupport(Target);
 	}
 }
@@ -12,7 +12,29 @@ DEFINE_LOG_CATEGORY(LogLockOnTarget);
 
 UE_TRACE_CHANNEL_DEFINE(LockOnTargetChannel);
 
+DEFINE_STAT(STAT_LOT_FindTarget);
+DEFINE_STAT(STAT_LOT_PrimarySampling);
+DEFINE_STAT(STAT_LOT_Solver);
+DEFINE_STAT(STAT_LOT_Sort);
+DEFINE_STAT(STAT_LOT_SecondarySampling);
+DEFINE_STAT(STAT_LOT_CheckTargetState);
+DEFINE_STAT(STAT_LOT_PrimarySamplingCandidatesIn);
+DEFINE_STAT(STAT_LOT_PrimarySamplingCandidatesOut);
+DEFINE_STAT(STAT_LOT_SecondarySamplingCandidatesIn);
+DEFINE_STAT(STAT_LOT_SecondarySamplingCandidatesTested);
+DEFINE_STAT(STAT_LOT_LineOfSightTraces);
+DEFINE_STAT(STAT_LOT_DetailedResponses);
+DEFINE_STAT(STAT_LOT_RegisteredTargets);
+
+TRACE_DECLARE_INT_COUNTER(LOT_PrimarySamplingCandidatesIn, TEXT("LockOnTarget/PrimarySampling Candidates In"));
+TRACE_DECLARE_INT_COUNTER(LOT_PrimarySamplingCandidatesOut, TEXT("LockOnTarget/PrimarySampling Candidates Out"));
+TRACE_DECLARE_INT_COUNTER(LOT_SecondarySamplingCandidatesIn, TEXT("LockOnTarget/SecondarySampling Candidates In"));
+TRACE_DECLARE_INT_COUNTER(LOT_SecondarySamplingCandidatesTested, TEXT("LockOnTarget/SecondarySampling Candidates Tested"));
+TRACE_DECLARE_INT_COUNTER(LOT_LineOfSightTraces, TEXT("LockOnTarget/LineOfSight Traces"));
+TRACE_DECLARE_INT_COUNTER(LOT_DetailedResponses, TEXT("LockOnTarget/Detailed Responses"));
+TRACE_DECLARE_INT_COUNTER(LOT_RegisteredTargets, TEXT("LockOnTarget/Registered Targets"));
+
 void FLockOnTargetModule::StartupModule()
 {
-	LOG("LockOnTarget(v%s): The LockOnTarget channel can be used to enable profiling. Traces can be sorted by the LOT_ prefix.", *IPluginManager::Get().FindPlugin("LockOnTarget")->GetDescriptor().VersionName);
+	LOG("LockOnTarget(v%s): The LockOnTarget channel can be used to enable profiling. Traces can be sorted by the LOT_ prefix. Stats are available via stat LockOnTarget.", *IPluginManager::Get().FindPlugin("LockOnTarget")->GetDescriptor().VersionName);
 }
@@ -2,6 +2,8 @@
 
 #include "LockOnTargetComponent.h"
 #include "TargetComponent.h"
+#include "TargetManager.h"
+#include "TargetValidationManager.h"
 #include "TargetHandlers/TargetHandlerBase.h"
 #include "LockOnTargetDefines.h"
 #include "LockOnTargetExtensions/LockOnTargetExtensionBase.h"
@@ -9,12 +11,23 @@
 #include "Net/UnrealNetwork.h"
 #include "Net/Core/PushModel/PushModel.h"
 #include "TimerManager.h"
+#include "Engine/DemoNetDriver.h"
 #include "Engine/Engine.h"
+#include "Engine/NetConnection.h"
 #include "Engine/World.h"
 #include "GameFramework/Actor.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "Net/Core/Misc/NetConditionGroupManager.h"
 
 ULockOnTargetComponent::ULockOnTargetComponent()
 	: bCanCaptureTarget(true)
+	, bScheduledTargetStateCheck(false)
+	, bUnreliableTargetSwitch(true)
+	, TargetSwitchConfirmationDelay(0.5f)
+	, TargetReplicationDistance(0.f)
+	, TargetReplicationUpdateInterval(0.5f)
+	, bRecordReplayEvents(false)
 	, InputBufferThreshold(.08f)
 	, BufferResetFrequency(.2f)
 	, ClampInputVector(-1.f, 1.f)
@@ -24,6 +37,8 @@ ULockOnTargetComponent::ULockOnTargetComponent()
 	, CurrentTargetInternal(FTargetInfo::NULL_TARGET)
 	, TargetingDuration(0.f)
 	, bIsTargetLocked(false)
+	, TargetUpdateSequence(0)
+	, TargetReplicationGroup(NAME_None)
 	, bInputFrozen(false)
 	, InputBuffer(0.f)
 	, InputVector(0.f)
@@ -60,6 +75,8 @@ void ULockOnTargetComponent::BeginPlay()
 	}
 
 	Extensions.Shrink();
+
+	StartTargetReplicationFiltering();
 }
 
 void ULockOnTargetComponent::EndPlay(EEndPlayReason::Type EndPlayReason)
@@ -75,6 +92,7 @@ void ULockOnTargetComponent::EndPlay(EEndPlayReason::Type EndPlayReason)
 
 	ClearTargetHandler();
 	RemoveAllExtensions();
+	StopTargetReplicationFiltering();
 
 	if (UWorld* const World = GetWorld())
 	{
@@ -93,7 +111,11 @@ void ULockOnTargetComponent::TickComponent(float DeltaTime, ELevelTick TickType,
 		if (HasAuthorityOverTarget())
 		{
 			ProcessAnalogInput(DeltaTime);
-			CheckTargetState(DeltaTime);
+
+			if (!bScheduledTargetStateCheck)
+			{
+				CheckTargetState(DeltaTime);
+			}
 		}
 	}
 }
@@ -113,6 +135,10 @@ void ULockOnTargetComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty
 
 	//Need to initially synchronize the timer for unmapped simulated proxies.
 	DOREPLIFETIME_CONDITION(ThisClass, TargetingDuration, COND_InitialOnly);
+
+	//Recorded into replays and their checkpoints only.
+	Params.Condition = COND_ReplayOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, ReplayStream, Params);
 }
 
 /*******************************************************************************************/
@@ -177,9 +203,41 @@ void ULockOnTargetComponent::RequestFindTarget(const FFindTargetRequestParams& R
 	LOT_SCOPED_EVENT(RequestFindTarget);
 	checkf(HasAuthorityOverTarget(), TEXT("Only the locally controlled owners are able to find a Target."));
 
-	if (GetTargetHandler())
+	if (UTargetHandlerBase* const TargetHandler = GetTargetHandler())
+	{
+		CancelPendingFindTargetRequest();
+
+		const FFindTargetRequestHandle Handle = TargetHandler->RequestFindTargetAsync(RequestParams, FOnFindTargetRequestCompleted::CreateUObject(this, &ThisClass::OnFindTargetRequestCompleted));
+
+		//Most requests are completed immediately.
+		if (TargetHandler->IsFindTargetRequestPending(Handle))
+		{
+			PendingFindTargetRequest = Handle;
+		}
+	}
+}
+
+void ULockOnTargetComponent::OnFindTargetRequestCompleted(FFindTargetRequestHandle Handle, const FFindTargetRequestResponse& Response)
+{
+	PendingFindTargetRequest.Invalidate();
+
+	//The state might have changed while the request was in progress.
+	if (CanCaptureTarget())
 	{
-		ProcessTargetHandlerResponse(GetTargetHandler()->FindTarget(RequestParams));
+		ProcessTargetHandlerResponse(Response);
+	}
+}
+
+void ULockOnTargetComponent::CancelPendingFindTargetRequest()
+{
+	if (PendingFindTargetRequest.IsValid())
+	{
+		if (IsValid(GetTargetHandler()))
+		{
+			GetTargetHandler()->CancelFindTargetRequest(PendingFindTargetRequest);
+		}
+
+		PendingFindTargetRequest.Invalidate();
 	}
 }
 
@@ -200,6 +258,7 @@ void ULockOnTargetComponent::ProcessTargetHandlerResponse(const FFindTargetReque
 void ULockOnTargetComponent::CheckTargetState(float DeltaTime)
 {
 	check(IsTargetLocked() && HasAuthorityOverTarget());
+	SCOPE_CYCLE_COUNTER(STAT_LOT_CheckTargetState);
 
 	if (GetTargetHandler())
 	{
@@ -253,6 +312,7 @@ void ULockOnTargetComponent::SetCanCaptureTarget(bool bInCanCaptureTarget)
 
 		if (!bCanCaptureTarget)
 		{
+			CancelPendingFindTargetRequest();
 			ClearTargetManual();
 		}
 	}
@@ -266,7 +326,7 @@ void ULockOnTargetComponent::SetLockOnTargetManual(AActor* NewTarget, FName Sock
 {
 	if (IsValid(NewTarget))
 	{
-		SetLockOnTargetManualByInfo({ NewTarget->FindComponentByClass<UTargetComponent>(), Socket });
+		SetLockOnTargetManualByInfo({ UTargetManager::FindTargetComponent(NewTarget), Socket });
 	}
 }
 
@@ -302,17 +362,30 @@ void ULockOnTargetComponent::ClearTargetManual()
 
 void ULockOnTargetComponent::UpdateTargetInfo(const FTargetInfo& TargetInfo)
 {
+	const bool bIsSwitch = IsTargetLocked() && IsValid(TargetInfo.TargetComponent);
+
 	//Update the Target locally.
-	Server_UpdateTargetInfo_Implementation(TargetInfo);
+	ApplyTargetInfo(TargetInfo);
 
 	//Update the Target on the server.
 	if (GetOwnerRole() == ROLE_AutonomousProxy)
 	{
-		Server_UpdateTargetInfo(TargetInfo);
+		FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+
+		if (bIsSwitch && bUnreliableTargetSwitch)
+		{
+			Server_SwitchTargetInfo(TargetInfo, ++TargetUpdateSequence);
+			TimerManager.SetTimer(TargetSwitchConfirmationHandle, this, &ThisClass::ConfirmTargetSwitch, FMath::Max(TargetSwitchConfirmationDelay, UE_KINDA_SMALL_NUMBER), false);
+		}
+		else
+		{
+			TimerManager.ClearTimer(TargetSwitchConfirmationHandle);
+			Server_UpdateTargetInfo(TargetInfo, ++TargetUpdateSequence);
+		}
 	}
 }
 
-void ULockOnTargetComponent::Server_UpdateTargetInfo_Implementation(const FTargetInfo& TargetInfo)
+void ULockOnTargetComponent::ApplyTargetInfo(const FTargetInfo& TargetInfo)
 {
 	if (TargetInfo != CurrentTargetInternal)
 	{
@@ -323,13 +396,290 @@ void ULockOnTargetComponent::Server_UpdateTargetInfo_Implementation(const FTarge
 	}
 }
 
-bool ULockOnTargetComponent::Server_UpdateTargetInfo_Validate(const FTargetInfo& TargetInfo)
+bool ULockOnTargetComponent::ShouldRecordReplayEvents() const
+{
+	const UWorld* const World = GetWorld();
+
+	//Playback restores the stream from the replay itself.
+	if (!bRecordReplayEvents || !World || World->IsPlayingReplay())
+	{
+		return false;
+	}
+
+	//Events are timed by the demo clock, so nothing is recorded until the recording starts.
+	const UDemoNetDriver* const DemoNetDriver = World->GetDemoNetDriver();
+
+	if (!DemoNetDriver || !DemoNetDriver->IsRecording())
+	{
+		return false;
+	}
+
+	//Clients record only into their own replays, e.g. kill-cams, as the server stream is never sent to them.
+	return GetOwnerRole() == ROLE_Authority || World->IsRecordingClientReplay();
+}
+
+void ULockOnTargetComponent::RecordReplayEvent(const FTargetInfo& OldTarget)
+{
+	ELockOnTargetReplayEventType Type = ELockOnTargetReplayEventType::Lock;
+
+	if (!IsValid(CurrentTargetInternal.TargetComponent))
+	{
+		Type = ELockOnTargetReplayEventType::Unlock;
+	}
+	else if (OldTarget.TargetComponent == CurrentTargetInternal.TargetComponent)
+	{
+		Type = ELockOnTargetReplayEventType::SocketChange;
+	}
+
+	//The demo time is used, so events can be compared with UDemoNetDriver::GetDemoCurrentTime() during playback.
+	const double DemoTime = GetWorld()->GetDemoNetDriver()->GetDemoCurrentTime();
+
+	//Events of the previous recording are timed by its own clock.
+	if (ReplayStream.Num() > 0 && ReplayStream[ReplayStream.Num() - 1].Time > DemoTime)
+	{
+		ReplayStream.Reset();
+	}
+
+	ReplayStream.Add(DemoTime, Type, CurrentTargetInternal, OldTarget);
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, ReplayStream, this);
+}
+
+void ULockOnTargetComponent::Server_UpdateTargetInfo_Implementation(const FTargetInfo& TargetInfo, uint8 Sequence)
+{
+	//Reliable updates may arrive after newer unreliable switches.
+	if (!IsTargetUpdateSequenceNewer(Sequence, TargetUpdateSequence))
+	{
+		return;
+	}
+
+	TargetUpdateSequence = Sequence;
+
+	//A confirmation of the last switch may hold the already captured Target.
+	if (!TargetInfo.TargetComponent || (IsTargetValid(TargetInfo.TargetComponent) && IsTargetClaimValid(TargetInfo)))
+	{
+		ApplyTargetInfo(TargetInfo);
+		Client_AckTargetUpdate(Sequence);
+	}
+	else
+	{
+		Client_RejectTargetUpdate(Sequence, CurrentTargetInternal);
+	}
+}
+
+void ULockOnTargetComponent::Server_SwitchTargetInfo_Implementation(const FTargetInfo& TargetInfo, uint8 Sequence)
+{
+	//Out of order and lost switches are dropped, the reliable confirmation will fix the state.
+	//The switch may also overtake the lost reliable capture, which is then resent and shouldn't be dropped as an older one.
+	if (!IsTargetLocked() || !IsTargetUpdateSequenceNewer(Sequence, TargetUpdateSequence))
+	{
+		return;
+	}
+
+	TargetUpdateSequence = Sequence;
+
+	if (TargetInfo == CurrentTargetInternal || (CanTargetBeCaptured(TargetInfo) && IsTargetClaimValid(TargetInfo)))
+	{
+		ApplyTargetInfo(TargetInfo);
+		Client_AckTargetUpdate(Sequence);
+	}
+	else
+	{
+		Client_RejectTargetUpdate(Sequence, CurrentTargetInternal);
+	}
+}
+
+bool ULockOnTargetComponent::IsTargetClaimValid(const FTargetInfo& TargetInfo)
+{
+	if (UTargetValidationManager::IsClaimValidationEnabled())
+	{
+		if (UTargetValidationManager* const ValidationManager = GetWorld()->GetSubsystem<UTargetValidationManager>())
+		{
+			return ValidationManager->ValidateTargetClaim(this, TargetInfo);
+		}
+	}
+
+	return true;
+}
+
+void ULockOnTargetComponent::RevokeTargetClaim()
+{
+	ApplyTargetInfo(FTargetInfo::NULL_TARGET);
+
+	//Newer predictions of the client will be validated on their own.
+	if (GetOwnerRole() == ROLE_Authority && GetOwner()->GetRemoteRole() == ROLE_AutonomousProxy)
+	{
+		Client_RejectTargetUpdate(TargetUpdateSequence, CurrentTargetInternal);
+	}
+}
+
+void ULockOnTargetComponent::Client_AckTargetUpdate_Implementation(uint8 Sequence)
+{
+	//The last switch has reached the server and doesn't need to be confirmed.
+	if (Sequence == TargetUpdateSequence)
+	{
+		GetWorld()->GetTimerManager().ClearTimer(TargetSwitchConfirmationHandle);
+	}
+}
+
+void ULockOnTargetComponent::Client_RejectTargetUpdate_Implementation(uint8 Sequence, const FTargetInfo& ServerTarget)
+{
+	//Newer predictions are acknowledged or rejected on their own.
+	if (Sequence == TargetUpdateSequence)
+	{
+		LOG_WARNING("The predicted Target %s was rejected by the server.", *GetNameSafe(GetTargetActor()));
+		GetWorld()->GetTimerManager().ClearTimer(TargetSwitchConfirmationHandle);
+
+		//Rolls back the prediction, so the predicted Target is released and the server one is captured by extensions as well.
+		ApplyTargetInfo(ServerTarget);
+	}
+}
+
+void ULockOnTargetComponent::StartTargetReplicationFiltering()
+{
+	AActor* const Owner = GetOwner();
+
+	if (TargetReplicationDistance > 0.f && GetIsReplicated() && Owner && Owner->HasAuthority() && !IsNetMode(NM_Standalone))
+	{
+		if (!Owner->IsUsingRegisteredSubObjectList())
+		{
+			LOG_WARNING("TargetReplicationDistance is ignored, as %s doesn't replicate using the registered subobject list.", *Owner->GetName());
+			return;
+		}
+
+		TargetReplicationGroup = FName(TEXT("LockOnTarget"), GetUniqueID());
+		UE::Net::FNetConditionGroupManager::RegisterSubObjectInGroup(this, TargetReplicationGroup);
+
+		//The owning connection and replays are members of the special groups, so they are never filtered by the distance.
+		UE::Net::FNetConditionGroupManager::RegisterSubObjectInGroup(this, UE::Net::NetGroupOwner);
+		UE::Net::FNetConditionGroupManager::RegisterSubObjectInGroup(this, UE::Net::NetGroupReplay);
+
+		Owner->SetReplicatedComponentNetCondition(this, COND_NetGroup);
+
+		//Joining and leaving players are handled individually instead of by the next full update.
+		PostLoginHandle = FGameModeEvents::GameModePostLoginEvent.AddUObject(this, &ThisClass::OnPlayerPostLogin);
+		LogoutHandle = FGameModeEvents::GameModeLogoutEvent.AddUObject(this, &ThisClass::OnPlayerLogout);
+
+		UpdateTargetReplicationGroup();
+
+		//Full updates of different components are spread over the interval.
+		GetWorld()->GetTimerManager().SetTimer(TargetReplicationUpdateHandle, this, &ThisClass::UpdateTargetReplicationGroup, TargetReplicationUpdateInterval, true, FMath::FRandRange(0.f, TargetReplicationUpdateInterval));
+	}
+}
+
+void ULockOnTargetComponent::StopTargetReplicationFiltering()
+{
+	if (!TargetReplicationGroup.IsNone())
+	{
+		FGameModeEvents::GameModePostLoginEvent.Remove(PostLoginHandle);
+		FGameModeEvents::GameModeLogoutEvent.Remove(LogoutHandle);
+		PostLoginHandle.Reset();
+		LogoutHandle.Reset();
+
+		if (UWorld* const World = GetWorld())
+		{
+			World->GetTimerManager().ClearTimer(TargetReplicationUpdateHandle);
+
+			//Otherwise the group outlives the component in each PlayerController.
+			for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+			{
+				if (APlayerController* const PlayerController = It->Get())
+				{
+					PlayerController->RemoveFromNetConditionGroup(TargetReplicationGroup);
+				}
+			}
+		}
+
+		UE::Net::FNetConditionGroupManager::UnregisterSubObjectFromGroup(this, TargetReplicationGroup);
+		UE::Net::FNetConditionGroupManager::UnregisterSubObjectFromGroup(this, UE::Net::NetGroupOwner);
+		UE::Net::FNetConditionGroupManager::UnregisterSubObjectFromGroup(this, UE::Net::NetGroupReplay);
+		TargetReplicationGroup = NAME_None;
+	}
+}
+
+void ULockOnTargetComponent::UpdateTargetReplicationGroup()
+{
+	if (TargetReplicationGroup.IsNone() || !GetOwner())
+	{
+		return;
+	}
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (APlayerController* const PlayerController = It->Get())
+		{
+			UpdateTargetReplicationMembership(PlayerController);
+		}
+	}
+}
+
+void ULockOnTargetComponent::UpdateTargetReplicationMembership(APlayerController* PlayerController)
+{
+	const AActor* const Owner = GetOwner();
+	const UNetConnection* const Connection = PlayerController->GetNetConnection();
+
+	//Local controllers have no connection to replicate to. Replay spectators are members of NetGroupReplay.
+	if (!Owner || !Connection || Connection->IsReplay())
+	{
+		return;
+	}
+
+	const AActor* const TargetActor = GetTargetActor();
+	const float DistanceSq = FMath::Square(TargetReplicationDistance);
+
+	const AActor* const ViewTarget = PlayerController->GetViewTarget();
+	const FVector ViewLocation = ViewTarget ? ViewTarget->GetActorLocation() : PlayerController->GetFocalLocation();
+
+	const bool bIsRelevant = FVector::DistSquared(ViewLocation, Owner->GetActorLocation()) <= DistanceSq
+		|| (TargetActor && FVector::DistSquared(ViewLocation, TargetActor->GetActorLocation()) <= DistanceSq);
+
+	if (bIsRelevant != PlayerController->IsMemberOfNetConditionGroup(TargetReplicationGroup))
+	{
+		if (bIsRelevant)
+		{
+			PlayerController->IncludeInNetConditionGroup(TargetReplicationGroup);
+		}
+		else
+		{
+			PlayerController->RemoveFromNetConditionGroup(TargetReplicationGroup);
+		}
+	}
+}
+
+void ULockOnTargetComponent::OnPlayerPostLogin(AGameModeBase* GameMode, APlayerController* NewPlayer)
 {
-	return !TargetInfo.TargetComponent || CanTargetBeCaptured(TargetInfo);
+	if (!TargetReplicationGroup.IsNone() && NewPlayer && NewPlayer->GetWorld() == GetWorld())
+	{
+		UpdateTargetReplicationMembership(NewPlayer);
+	}
+}
+
+void ULockOnTargetComponent::OnPlayerLogout(AGameModeBase* GameMode, AController* Exiting)
+{
+	if (APlayerController* const PlayerController = Cast<APlayerController>(Exiting); PlayerController && !TargetReplicationGroup.IsNone())
+	{
+		PlayerController->RemoveFromNetConditionGroup(TargetReplicationGroup);
+	}
+}
+
+void ULockOnTargetComponent::ConfirmTargetSwitch()
+{
+	if (IsTargetLocked() && GetOwnerRole() == ROLE_AutonomousProxy)
+	{
+		Server_UpdateTargetInfo(CurrentTargetInternal, ++TargetUpdateSequence);
+	}
 }
 
 void ULockOnTargetComponent::OnTargetInfoUpdated(const FTargetInfo& OldTarget)
 {
+	//Covers local changes and ones received by clients.
+	if (ShouldRecordReplayEvents())
+	{
+		RecordReplayEvent(OldTarget);
+	}
+
+	//The pending request is based on the old Target.
+	CancelPendingFindTargetRequest();
+
 	if (IsValid(CurrentTargetInternal.TargetComponent))
 	{
 		if (OldTarget.TargetComponent == CurrentTargetInternal.TargetComponent)
@@ -366,6 +716,14 @@ void ULockOnTargetComponent::NotifyTargetCaptured(const FTargetInfo& Target)
 	SetComponentTickEnabled(true);
 	Target->NotifyTargetCaptured(this);
 
+	if (bScheduledTargetStateCheck && HasAuthorityOverTarget())
+	{
+		if (UTargetManager* const TargetManager = GetWorld()->GetSubsystem<UTargetManager>())
+		{
+			TargetManager->ScheduleTargetStateCheck(this);
+		}
+	}
+
 	if (HasBegunPlay())
 	{
 		ForEachSubobject([&Target](ULockOnTargetExtensionProxy* Extension)
@@ -388,6 +746,14 @@ void ULockOnTargetComponent::NotifyTargetReleased(const FTargetInfo& Target)
 	SetComponentTickEnabled(false);
 	Target->NotifyTargetReleased(this);
 
+	if (bScheduledTargetStateCheck)
+	{
+		if (UTargetManager* const TargetManager = GetWorld()->GetSubsystem<UTargetManager>())
+		{
+			TargetManager->UnscheduleTargetStateCheck(this);
+		}
+	}
+
 	ForEachSubobject([&Target](ULockOnTargetExtensionProxy* Extension)
 		{
 			Extension->OnTargetUnlocked(Target.TargetComponent, Target.Socket);
@@ -433,7 +799,7 @@ void ULockOnTargetComponent::ReceiveTargetException(ETargetExceptionType Excepti
 	const FTargetInfo Target = CurrentTargetInternal;
 
 	//Clear Target locally.
-	Server_UpdateTargetInfo_Implementation(FTargetInfo::NULL_TARGET);
+	ApplyTargetInfo(FTargetInfo::NULL_TARGET);
 
 	if (!GetWorld()->bIsTearingDown && HasAuthorityOverTarget())
 	{
@@ -445,7 +811,8 @@ void ULockOnTargetComponent::ReceiveTargetException(ETargetExceptionType Excepti
 		//If Target is still null, then sync with the server if needed.
 		if (!IsTargetLocked() && GetOwnerRole() == ROLE_AutonomousProxy)
 		{
-			Server_UpdateTargetInfo(FTargetInfo::NULL_TARGET);
+			GetWorld()->GetTimerManager().ClearTimer(TargetSwitchConfirmationHandle);
+			Server_UpdateTargetInfo(FTargetInfo::NULL_TARGET, ++TargetUpdateSequence);
 		}
 	}
 }
@@ -529,6 +896,7 @@ void ULockOnTargetComponent::ClearTargetHandler()
 {
 	if (IsValid(GetTargetHandler()))
 	{
+		CancelPendingFindTargetRequest();
 		DestroySubobject(GetTargetHandler());
 		TargetHandlerImplementation = nullptr;
 	}
@@ -641,7 +1009,7 @@ void ULockOnTargetComponent::ProcessAnalogInput(float DeltaTime)
 	if (InputBuffer.SizeSquared() > FMath::Square(InputBufferThreshold))
 	{
 		bInputFrozen = bUseInputFreezing;
-		ActivateInputDelay(); //Prevent reliable buffer overflow.
+		ActivateInputDelay(); //Prevents multiple switches per flick. Also protects the reliable buffer if bUnreliableTargetSwitch is disabled.
 		{
 			FFindTargetRequestParams RequestParams;
 			RequestParams.PlayerInput = InputBuffer;
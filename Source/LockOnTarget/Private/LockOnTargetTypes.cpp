@@ -2,7 +2,9 @@
 
 #include "LockOnTargetTypes.h"
 #include "TargetComponent.h"
+#include "TargetManager.h"
 #include "GameFramework/Actor.h"
+#include "Algo/BinarySearch.h"
 
 /********************************************************************
  * FTargetInfo
@@ -12,7 +14,7 @@ const FTargetInfo FTargetInfo::NULL_TARGET = { nullptr, NAME_None };
 
 bool FTargetInfo::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
 {
-	//[ IsTargetValid? ]~[ NetGUID/Name ][ IsDefaultSocket? ]~[ Socket Idx ]
+	//[ IsTargetValid? ]~[ NetGUID/Name ][ IsDefaultSocket? ]~[ Socket Idx Width Code ][ Socket Idx ]
 
 	bool bTargetMapped = true;
 	bOutSuccess = true;
@@ -36,8 +38,8 @@ bool FTargetInfo::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess
 		{
 			if(bTargetMapped)
 			{
-				TargetComponent = static_cast<AActor*>(TargetOwner)->FindComponentByClass<UTargetComponent>();
-				checkf(TargetComponent, TEXT("Serialized Target %s doesn't have UTargetComponent."), *GetFullNameSafe(TargetOwner));
+				//A client may send any actor, so a missing Target results in the null Target.
+				TargetComponent = UTargetManager::FindTargetComponent(Cast<AActor>(TargetOwner));
 			}
 			else
 			{
@@ -62,9 +64,26 @@ bool FTargetInfo::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess
 		
 		if(!bDefaultSocket)
 		{
-			//We could only serialize significant bits with FMath::CeilLogTwo(MaxIndex), 
-			//but if the Target isn't mapped, we can't safely deserialize it.
-			Ar.SerializeIntPacked(SocketIdx);
+			//The width is derived from the index itself and serialized along with it,
+			//so the index can be read even if the Target isn't mapped on the receiver.
+			uint32 WidthCode = 0;
+
+			if (Ar.IsSaving())
+			{
+				WidthCode = GetSocketIndexWidthCode(SocketIdx);
+			}
+
+			Ar.SerializeInt(WidthCode, 1 << SocketIndexWidthCodeBits);
+
+			if (WidthCode == SocketIndexWidthCodePacked)
+			{
+				Ar.SerializeIntPacked(SocketIdx);
+			}
+			else
+			{
+				//The max is a power of two, so exactly WidthCode + 1 bits are serialized.
+				Ar.SerializeInt(SocketIdx, 1 << (WidthCode + 1));
+			}
 		}
 
 		if (Ar.IsLoading())
@@ -74,7 +93,8 @@ bool FTargetInfo::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess
 			{
 				const TArray<FName>& Sockets = TargetComponent->GetSockets();
 
-				if (ensureMsgf(Sockets.IsValidIndex(SocketIdx), TEXT("An invalid Socket index was received from NetSerialize.")))
+				//The index comes from the network, e.g. from a client RPC, so it's validated without asserting.
+				if (Sockets.IsValidIndex(SocketIdx))
 				{
 					Socket = Sockets[SocketIdx];
 				}
@@ -110,6 +130,61 @@ uint32 FTargetInfo::GetSocketIndex() const
 	return Index;
 }
 
+uint32 FTargetInfo::GetSocketIndexWidthCode(uint32 SocketIndex)
+{
+	//Indices below 128 fit in at most 7 bits, which is cheaper than a packed int of at least 8 bits. Greater ones are packed.
+	return FMath::Min(FMath::Max(FMath::CeilLogTwo(SocketIndex + 1), 1u) - 1, SocketIndexWidthCodePacked);
+}
+
+/********************************************************************
+ * FLockOnTargetReplayStream
+ ********************************************************************/
+
+void FLockOnTargetReplayStream::Add(double Time, ELockOnTargetReplayEventType Type, const FTargetInfo& Target, const FTargetInfo& PrevTarget)
+{
+	if (Events.IsEmpty())
+	{
+		FLockOnTargetReplayEvent& BaseEvent = Events.AddDefaulted_GetRef();
+		BaseEvent.Time = 0.0;
+		BaseEvent.Type = ELockOnTargetReplayEventType::Base;
+		BaseEvent.Target = PrevTarget;
+		MarkItemDirty(BaseEvent);
+	}
+	else if (Events.Num() == Capacity)
+	{
+		//The oldest event becomes the new base, as its Target is the one captured at the start of the window.
+		Events.RemoveAt(0, 1, false);
+		Events[0].Type = ELockOnTargetReplayEventType::Base;
+		MarkItemDirty(Events[0]);
+		MarkArrayDirty();
+	}
+
+	FLockOnTargetReplayEvent& Event = Events.AddDefaulted_GetRef();
+	Event.Time = Time;
+	Event.Type = Type;
+	Event.Target = Target;
+	MarkItemDirty(Event);
+}
+
+void FLockOnTargetReplayStream::Reset()
+{
+	Events.Reset();
+	MarkArrayDirty();
+}
+
+int32 FLockOnTargetReplayStream::FindLastEventIndex(double Time) const
+{
+	//The first event after the time.
+	const int32 First = Algo::UpperBoundBy(Events, Time, &FLockOnTargetReplayEvent::Time);
+	return First - 1;
+}
+
+FTargetInfo FLockOnTargetReplayStream::GetTargetAtTime(double Time) const
+{
+	const int32 Index = FindLastEventIndex(Time);
+	return Index != INDEX_NONE ? Events[Index].Target : FTargetInfo::NULL_TARGET;
+}
+
 #if 0
 
 /**
@@ -6,6 +6,9 @@
 #include "LockOnTargetDefines.h"
 
 #include "Components/SceneComponent.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
 
 UTargetComponent::UTargetComponent()
 	: bCanBeCaptured(true)
@@ -51,6 +54,9 @@ void UTargetComponent::InitializeComponent()
 			}
 		}
 	}
+
+	BindAssociatedComponent();
+	RebuildSocketsCache();
 }
 
 void UTargetComponent::SetAssociatedComponent(USceneComponent* InAssociatedComponent)
@@ -58,8 +64,11 @@ void UTargetComponent::SetAssociatedComponent(USceneComponent* InAssociatedCompo
 	if (IsValid(InAssociatedComponent) && InAssociatedComponent != AssociatedComponent.Get())
 	{
 		check(!InAssociatedComponent->IsEditorOnly());
+		UnbindAssociatedComponent();
 		AssociatedComponent = InAssociatedComponent;
 		AssociatedComponentName = InAssociatedComponent->GetFName(); //For proper display in details.
+		BindAssociatedComponent();
+		RebuildSocketsCache();
 	}
 }
 
@@ -77,6 +86,7 @@ void UTargetComponent::EndPlay(EEndPlayReason::Type Reason)
 	bCanBeCaptured = false;
 	DispatchTargetException(ETargetExceptionType::Destruction);
 	GetTargetManager().UnregisterTarget(this);
+	UnbindAssociatedComponent();
 }
 
 bool UTargetComponent::CanBeCaptured() const
@@ -95,6 +105,7 @@ void UTargetComponent::SetCanBeCaptured(bool bInCanBeCaptured)
 	if (bCanBeCaptured != bInCanBeCaptured)
 	{
 		bCanBeCaptured = bInCanBeCaptured;
+		RefreshTargetManagerData();
 
 		if (!bCanBeCaptured)
 		{
@@ -137,9 +148,128 @@ void UTargetComponent::DispatchTargetException(ETargetExceptionType Exception)
 	}
 }
 
+void UTargetComponent::RefreshTargetManagerData()
+{
+	if (const UWorld* const World = GetWorld())
+	{
+		if (UTargetManager* const TargetManager = World->GetSubsystem<UTargetManager>())
+		{
+			TargetManager->RefreshTarget(this);
+		}
+	}
+}
+
 FVector UTargetComponent::GetSocketLocation(FName Socket) const
 {
-	return AssociatedComponent.IsValid() ? AssociatedComponent->GetSocketLocation(Socket) : GetOwner()->GetActorLocation();
+	FTargetSocketLocationCache* const Cache = SocketsCache.FindByPredicate([Socket](const FTargetSocketLocationCache& Entry)
+		{
+			return Entry.Socket == Socket;
+		});
+
+	//Sockets that aren't Target Sockets, e.g. the custom focus point, aren't cached.
+	if (!Cache)
+	{
+		return CalcSocketLocation(Socket, INDEX_NONE);
+	}
+
+	if (Cache->Frame != GFrameCounter)
+	{
+		Cache->Location = CalcSocketLocation(Socket, Cache->BoneIndex);
+		Cache->Frame = GFrameCounter;
+	}
+
+	return Cache->Location;
+}
+
+FVector UTargetComponent::CalcSocketLocation(FName Socket, int32 BoneIndex) const
+{
+	if (!AssociatedComponent.IsValid())
+	{
+		return GetOwner()->GetActorLocation();
+	}
+
+	if (BoneIndex != INDEX_NONE)
+	{
+		//The mesh might have been changed since the bone was resolved.
+		const USkinnedMeshComponent* const SkinnedMesh = static_cast<const USkinnedMeshComponent*>(AssociatedComponent.Get());
+
+		if (SkinnedMesh->GetBoneName(BoneIndex) == Socket)
+		{
+			return SkinnedMesh->GetBoneTransform(BoneIndex).GetLocation();
+		}
+	}
+
+	return AssociatedComponent->GetSocketLocation(Socket);
+}
+
+void UTargetComponent::RebuildSocketsCache()
+{
+	const USkinnedMeshComponent* const SkinnedMesh = Cast<USkinnedMeshComponent>(AssociatedComponent.Get());
+
+	SocketsCache.Reset();
+
+	for (const FName Socket : Sockets)
+	{
+		FTargetSocketLocationCache& Cache = SocketsCache.AddDefaulted_GetRef();
+		Cache.Socket = Socket;
+
+		//Only bones are resolved, as mesh sockets and other components are looked up by name anyway.
+		if (SkinnedMesh && !Socket.IsNone())
+		{
+			Cache.BoneIndex = SkinnedMesh->GetBoneIndex(Socket);
+		}
+	}
+}
+
+void UTargetComponent::InvalidateSocketsCache() const
+{
+	for (FTargetSocketLocationCache& Cache : SocketsCache)
+	{
+		Cache.Frame = TNumericLimits<uint64>::Max();
+	}
+}
+
+void UTargetComponent::BindAssociatedComponent()
+{
+	if (AssociatedComponent.IsValid() && !AssociatedComponentTransformUpdatedHandle.IsValid())
+	{
+		AssociatedComponentTransformUpdatedHandle = AssociatedComponent->TransformUpdated.AddUObject(this, &ThisClass::OnAssociatedComponentTransformUpdated);
+
+		//The pose isn't final until animation is finished, so locations of bones cached before that are outdated.
+		if (USkeletalMeshComponent* const SkeletalMesh = Cast<USkeletalMeshComponent>(AssociatedComponent.Get()))
+		{
+			AssociatedComponentBoneTransformsFinalizedHandle = SkeletalMesh->RegisterOnBoneTransformsFinalizedDelegate(
+				FOnBoneTransformsFinalizedMultiCast::FDelegate::CreateUObject(this, &ThisClass::OnAssociatedComponentBoneTransformsFinalized));
+		}
+	}
+}
+
+void UTargetComponent::UnbindAssociatedComponent()
+{
+	if (AssociatedComponent.IsValid())
+	{
+		AssociatedComponent->TransformUpdated.Remove(AssociatedComponentTransformUpdatedHandle);
+
+		if (USkeletalMeshComponent* const SkeletalMesh = Cast<USkeletalMeshComponent>(AssociatedComponent.Get()))
+		{
+			SkeletalMesh->UnregisterOnBoneTransformsFinalizedDelegate(AssociatedComponentBoneTransformsFinalizedHandle);
+		}
+	}
+
+	AssociatedComponentTransformUpdatedHandle.Reset();
+	AssociatedComponentBoneTransformsFinalizedHandle.Reset();
+}
+
+void UTargetComponent::OnAssociatedComponentTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	//The component might have moved after the locations were cached within the frame.
+	InvalidateSocketsCache();
+}
+
+void UTargetComponent::OnAssociatedComponentBoneTransformsFinalized()
+{
+	//Readers before this point got the previous pose.
+	InvalidateSocketsCache();
 }
 
 void UTargetComponent::SetDefaultSocket(FName Socket)
@@ -147,10 +277,14 @@ void UTargetComponent::SetDefaultSocket(FName Socket)
 	if (Sockets.IsEmpty())
 	{
 		Sockets.Add(Socket);
+		RebuildSocketsCache();
+		RefreshTargetManagerData();
 	}
 	else if (Sockets[0] != Socket)
 	{
 		Sockets[0] = Socket;
+		RebuildSocketsCache();
+		RefreshTargetManagerData();
 
 		DispatchTargetException(ETargetExceptionType::SocketInvalidation);
 	}
@@ -163,6 +297,8 @@ bool UTargetComponent::AddSocket(FName Socket)
 	if (bIsSuccessful)
 	{
 		Sockets.Add(Socket);
+		RebuildSocketsCache();
+		RefreshTargetManagerData();
 	}
 
 	return bIsSuccessful;
@@ -174,6 +310,8 @@ bool UTargetComponent::RemoveSocket(FName Socket)
 
 	if (bIsSuccessful)
 	{
+		RebuildSocketsCache();
+		RefreshTargetManagerData();
 		DispatchTargetException(ETargetExceptionType::SocketInvalidation);
 	}
 
@@ -30,3 +30,72 @@ bool UTargetHandlerBase::IsTargetValid(const UTargetComponent* Target) const
 	check(GetLockOnTargetComponent());
 	return GetLockOnTargetComponent()->IsTargetValid(Target);
 }
+
+void UTargetHandlerBase::Deinitialize(ULockOnTargetComponent* Instigator)
+{
+	CancelAllFindTargetRequests();
+	Super::Deinitialize(Instigator);
+}
+
+/*******************************************************************************************/
+/*******************************  Async Requests  ******************************************/
+/*******************************************************************************************/
+
+FFindTargetRequestHandle FFindTargetRequestHandle::GenerateNewHandle()
+{
+	static uint32 LastId = 0;
+
+	FFindTargetRequestHandle NewHandle;
+
+	//0 is reserved for invalid handles.
+	if (++LastId == 0)
+	{
+		++LastId;
+	}
+
+	NewHandle.Id = LastId;
+	return NewHandle;
+}
+
+FFindTargetRequestHandle UTargetHandlerBase::RequestFindTargetAsync(const FFindTargetRequestParams& RequestParams, FOnFindTargetRequestCompleted OnCompleted)
+{
+	const FFindTargetRequestHandle Handle = FFindTargetRequestHandle::GenerateNewHandle();
+	PendingRequests.Add(Handle, MoveTemp(OnCompleted));
+	FindTargetAsync(Handle, RequestParams);
+	return Handle;
+}
+
+void UTargetHandlerBase::CancelFindTargetRequest(FFindTargetRequestHandle Handle)
+{
+	if (PendingRequests.Remove(Handle) > 0)
+	{
+		OnFindTargetRequestCancelled(Handle);
+	}
+}
+
+void UTargetHandlerBase::CancelAllFindTargetRequests()
+{
+	TArray<FFindTargetRequestHandle> Handles;
+	PendingRequests.GenerateKeyArray(Handles);
+
+	for (const FFindTargetRequestHandle Handle : Handles)
+	{
+		CancelFindTargetRequest(Handle);
+	}
+}
+
+void UTargetHandlerBase::FindTargetAsync(FFindTargetRequestHandle Handle, const FFindTargetRequestParams& RequestParams)
+{
+	CompleteFindTargetRequest(Handle, FindTarget(RequestParams));
+}
+
+void UTargetHandlerBase::CompleteFindTargetRequest(FFindTargetRequestHandle Handle, const FFindTargetRequestResponse& Response)
+{
+	FOnFindTargetRequestCompleted OnCompleted;
+
+	//Removed before the execution, as the delegate may start a new request.
+	if (PendingRequests.RemoveAndCopyValue(Handle, OnCompleted))
+	{
+		OnCompleted.ExecuteIfBound(Handle, Response);
+	}
+}
@@ -7,11 +7,24 @@
 #include "LockOnTargetDefines.h"
 
 #include "CollisionQueryParams.h"
+#include "Components/SceneComponent.h"
 #include "Engine/World.h"
 #include "GameFramework/PlayerController.h"
 #include "TimerManager.h"
+#include "Tasks/Task.h"
 #include "Blueprint/WidgetLayoutLibrary.h"
 
+namespace
+{
+	struct FTargetContextWeightPredicate
+	{
+		bool operator()(const FTargetContext& lhs, const FTargetContext& rhs) const
+		{
+			return lhs.Weight < rhs.Weight;
+		}
+	};
+}
+
 UWeightedTargetHandler::UWeightedTargetHandler()
 	: AutoFindTargetFlags(0b00011111)
 	, DistanceWeight(0.725f)
@@ -22,11 +35,13 @@ UWeightedTargetHandler::UWeightedTargetHandler()
 	, DistanceMaxFactor(2420.f)
 	, DeltaAngleMaxFactor(45.f)
 	, MinimumFactorThreshold(0.035f)
+	, bAsyncSolver(false)
 	, bDistanceCheck(true)
 	, DefaultCaptureRadius(2200.f)
 	, LostRadiusScale(1.1f)
 	, NearClipRadius(150.f)
 	, CaptureRadiusScale(1.f)
+	, bEventDrivenDistanceCheck(false)
 	, ViewConeAngle(42.f)
 	, ViewPitchOffset(10.f)
 	, ViewYawOffset(0.f)
@@ -35,22 +50,135 @@ UWeightedTargetHandler::UWeightedTargetHandler()
 	, bRecentRenderCheck(true)
 	, RecentTolerance(0.1f)
 	, PlayerInputAngularRange(60.f)
+	, bSwitchNeighbourGraph(false)
+	, SwitchNeighbourGraphInterval(0.5f)
+	, SwitchNeighbourGraphMovementThreshold(150.f)
 	, bLineOfSightCheck(true)
 	, TraceCollisionChannel(ECollisionChannel::ECC_Visibility)
 	, LostTargetDelay(3.f)
 	, CheckInterval(0.2f)
+	, bAsyncLineOfSight(false)
+	, bAsyncSecondarySampling(false)
+	, AsyncSecondarySamplingBatchSize(4)
 	, LineOfSightCheckTimer(0.f)
+	, DeferredPendingTracesNum(0)
+	, bDistanceCheckPending(true)
+	, SwitchNeighbourGraphTime(0.f)
+	, SwitchNeighbourGraphViewLocation(0.f)
+	, SwitchNeighbourGraphTargetLocation(0.f)
 {
 	ExtensionTick.bCanEverTick = false;
+	LineOfSightTraceDelegate.BindUObject(this, &ThisClass::OnAsyncLineOfSightTraceCompleted);
+	DeferredTraceDelegate.BindUObject(this, &ThisClass::OnDeferredLineOfSightTraceCompleted);
 }
 
 FFindTargetRequestResponse UWeightedTargetHandler::FindTarget_Implementation(const FFindTargetRequestParams& RequestParams)
 {
+	FFindTargetRequestResponse NeighbourResponse;
+
+	if (TryFindSwitchNeighbour(RequestParams, NeighbourResponse))
+	{
+		return NeighbourResponse;
+	}
+
 	const EFindTargetContextMode ContextMode = GetLockOnTargetComponent()->IsTargetLocked() ? EFindTargetContextMode::Switch : EFindTargetContextMode::Find;
 	FFindTargetContext Context = CreateFindTargetContext(ContextMode, RequestParams);
 	return FindTargetBatched(Context);
 }
 
+void UWeightedTargetHandler::FindTargetAsync(FFindTargetRequestHandle Handle, const FFindTargetRequestParams& RequestParams)
+{
+	const bool bUseAsyncSolver = bAsyncSolver && CanUseBatchedSolver();
+	const bool bUseDeferredSampling = bLineOfSightCheck && bAsyncSecondarySampling;
+
+	//Blueprint overrides are synchronous.
+	if ((!bUseAsyncSolver && !bUseDeferredSampling) || GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UWeightedTargetHandler, FindTarget)))
+	{
+		Super::FindTargetAsync(Handle, RequestParams);
+		return;
+	}
+
+	//Only the latest request is processed.
+	if (AsyncRequestHandle.IsValid())
+	{
+		CancelFindTargetRequest(AsyncRequestHandle);
+	}
+
+	FFindTargetRequestResponse NeighbourResponse;
+
+	if (TryFindSwitchNeighbour(RequestParams, NeighbourResponse))
+	{
+		CompleteFindTargetRequest(Handle, NeighbourResponse);
+		return;
+	}
+
+	AsyncRequestHandle = Handle;
+
+	const EFindTargetContextMode ContextMode = GetLockOnTargetComponent()->IsTargetLocked() ? EFindTargetContextMode::Switch : EFindTargetContextMode::Find;
+	FFindTargetContext Context = CreateFindTargetContext(ContextMode, RequestParams);
+	Context.bAllowDeferredResponse = true;
+
+	if (bUseAsyncSolver)
+	{
+		TArray<FTargetContext> TargetsData;
+
+		{
+			LOT_SCOPED_EVENT(WTH_Pass_PrimarySampling);
+			PerformPrimarySamplingPass(Context, /*out*/TargetsData);
+		}
+
+		if (TargetsData.Num() > 0)
+		{
+			LaunchAsyncSolver(Context, MoveTemp(TargetsData));
+		}
+		else
+		{
+			CompleteOrDeferAsyncRequest(FFindTargetRequestResponse());
+		}
+	}
+	else
+	{
+		CompleteOrDeferAsyncRequest(FindTargetBatched(Context));
+	}
+}
+
+void UWeightedTargetHandler::OnFindTargetRequestCancelled(FFindTargetRequestHandle Handle)
+{
+	Super::OnFindTargetRequestCancelled(Handle);
+
+	if (Handle == AsyncRequestHandle)
+	{
+		CancelAsyncRequest();
+	}
+}
+
+void UWeightedTargetHandler::CompleteOrDeferAsyncRequest(const FFindTargetRequestResponse& Response)
+{
+	//Will be completed once the deferred secondary pass is resolved.
+	if (DeferredPendingTracesNum == 0)
+	{
+		const FFindTargetRequestHandle Handle = AsyncRequestHandle;
+		AsyncRequestHandle.Invalidate();
+		CompleteFindTargetRequest(Handle, Response);
+	}
+}
+
+void UWeightedTargetHandler::CancelAsyncRequest()
+{
+	AsyncRequestHandle.Invalidate();
+	CancelDeferredSecondarySampling();
+
+	//The running task can't be stopped, but its result is dropped.
+	AsyncSolverTask = {};
+	AsyncSolverContext = FFindTargetContext();
+	AsyncSolverTargets.Reset();
+
+	if (const UWorld* const World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(AsyncSolverPollHandle);
+	}
+}
+
 void UWeightedTargetHandler::CheckTargetState_Implementation(const FTargetInfo& Target, float DeltaTime)
 {
 	LOT_SCOPED_EVENT(WTH_CheckTargetState);
@@ -61,11 +189,14 @@ void UWeightedTargetHandler::CheckTargetState_Implementation(const FTargetInfo&
 
 	const AActor* const TargetActor = Target->GetOwner();
 
-	if (bDistanceCheck)
+	if (bDistanceCheck && bDistanceCheckPending)
 	{
 		const float DistanceSq = (TargetActor->GetActorLocation() - ViewLocation).SizeSquared();
 		const float TargetLostRadius = GetTargetCaptureRadius(Target.TargetComponent) * LostRadiusScale;
 
+		//Skipped until the next movement.
+		bDistanceCheckPending = !bEventDrivenDistanceCheck || !OwnerRootComponent.IsValid() || !TargetRootComponent.IsValid();
+
 		if (DistanceSq > FMath::Square(TargetLostRadius))
 		{
 			HandleTargetUnlock(ETargetUnlockReason::DistanceFailure);
@@ -81,8 +212,11 @@ void UWeightedTargetHandler::CheckTargetState_Implementation(const FTargetInfo&
 		{
 			LineOfSightCheckTimer = 0.f;
 
-			//@TODO: Maybe use AsyncLineTrace.
-			if (LineOfSightTrace(ViewLocation, Target->GetSocketLocation(Target.Socket), TargetActor))
+			if (bAsyncLineOfSight)
+			{
+				RequestAsyncLineOfSightTrace(ViewLocation, Target->GetSocketLocation(Target.Socket), TargetActor);
+			}
+			else if (LineOfSightTrace(ViewLocation, Target->GetSocketLocation(Target.Socket), TargetActor))
 			{
 				StopLineOfSightTimer();
 			}
@@ -99,11 +233,28 @@ void UWeightedTargetHandler::HandleTargetException_Implementation(const FTargetI
 	HandleTargetUnlock(ConvertTargetExceptionToUnlockReason(Exception));
 }
 
+void UWeightedTargetHandler::OnTargetLocked(UTargetComponent* Target, FName Socket)
+{
+	Super::OnTargetLocked(Target, Socket);
+	bDistanceCheckPending = true;
+
+	if (bDistanceCheck && bEventDrivenDistanceCheck)
+	{
+		BindDistanceCheckEvents(Target);
+	}
+}
+
 void UWeightedTargetHandler::OnTargetUnlocked(UTargetComponent* UnlockedTarget, FName Socket)
 {
 	Super::OnTargetUnlocked(UnlockedTarget, Socket);
+	UnbindDistanceCheckEvents();
+	bDistanceCheckPending = true;
 	StopLineOfSightTimer();
 	LineOfSightCheckTimer = 0.f;
+
+	//The result of the trace in flight is ignored.
+	LineOfSightTraceHandle.Invalidate();
+	ResetSwitchNeighbourGraph();
 }
 
 /*******************************************************************************************/
@@ -113,6 +264,7 @@ void UWeightedTargetHandler::OnTargetUnlocked(UTargetComponent* UnlockedTarget,
 FFindTargetRequestResponse UWeightedTargetHandler::FindTargetBatched(FFindTargetContext& Context)
 {
 	LOT_SCOPED_EVENT(WTH_BatchedFinding);
+	SCOPE_CYCLE_COUNTER(STAT_LOT_FindTarget);
 
 	FFindTargetRequestResponse OutResponse;
 	TArray<FTargetContext> TargetsData;
@@ -131,10 +283,17 @@ FFindTargetRequestResponse UWeightedTargetHandler::FindTargetBatched(FFindTarget
 
 		{
 			LOT_SCOPED_EVENT(WTH_Pass_Sort);
-			TargetsData.Sort([](const auto& lhs, const auto& rhs)
-				{
-					return lhs.Weight < rhs.Weight;
-				});
+			SCOPE_CYCLE_COUNTER(STAT_LOT_Sort);
+
+			//Only the detailed response needs all Targets in order, otherwise they're lazily popped from the heap.
+			if (Context.RequestParams.bGenerateDetailedResponse)
+			{
+				TargetsData.Sort(FTargetContextWeightPredicate());
+			}
+			else
+			{
+				TargetsData.Heapify(FTargetContextWeightPredicate());
+			}
 		}
 
 		{
@@ -148,21 +307,60 @@ FFindTargetRequestResponse UWeightedTargetHandler::FindTargetBatched(FFindTarget
 
 void UWeightedTargetHandler::PerformPrimarySamplingPass(FFindTargetContext& Context, TArray<FTargetContext>& OutTargetsData)
 {
-	const TSet<UTargetComponent*>& RegisteredTargets = UTargetManager::Get(*GetWorld()).GetRegisteredTargets();
+	CONDITIONAL_SCOPE_CYCLE_COUNTER(STAT_LOT_PrimarySampling, Context.bTrackStats);
+
+	UTargetManager& TargetManager = UTargetManager::Get(*GetWorld());
+	const FRegisteredTargetsData& RegisteredTargetsData = TargetManager.GetTargetsData();
+	TArray<int32> Candidates;
+
+	if (bDistanceCheck)
+	{
+		//Targets may force a custom radius, so each radius bucket is queried separately.
+		TargetManager.QueryTargetIndicesInCaptureRadius(Context.ViewLocation, DefaultCaptureRadius, CaptureRadiusScale, Candidates);
+	}
+	else
+	{
+		Candidates.Reserve(RegisteredTargetsData.Num());
+
+		for (int32 i = 0; i < RegisteredTargetsData.Num(); ++i)
+		{
+			Candidates.Add(i);
+		}
+	}
+
+	if (Context.bTrackStats)
+	{
+		LOT_COUNTER_SET(PrimarySamplingCandidatesIn, Candidates.Num());
+	}
 
 	OutTargetsData.Empty();
-	OutTargetsData.Reserve(RegisteredTargets.Num());
+	OutTargetsData.Reserve(Candidates.Num());
 
-	for (UTargetComponent* const Target : RegisteredTargets)
+	for (const int32 Index : Candidates)
 	{
-		if (ShouldSkipTargetPrimaryPass(Context, Target))
+		if (ShouldSkipTargetPrimaryPass(Context, RegisteredTargetsData, Index))
+		{
+			continue;
+		}
+
+		UTargetComponent* const Target = RegisteredTargetsData.Targets[Index];
+
+		//The packed data may be a frame old, so a Target destroyed earlier in this frame is still there.
+		if (!IsValid(Target))
+		{
+			continue;
+		}
+
+		if (bRecentRenderCheck && !Target->GetOwner()->WasRecentlyRendered(RecentTolerance))
 		{
 			continue;
 		}
 
-		for (const FName TargetSocket : Target->GetSockets())
+		const TArray<FName>& Sockets = Target->GetSockets();
+
+		for (int32 SocketIndex = 0; SocketIndex < Sockets.Num(); ++SocketIndex)
 		{
-			const FTargetInfo CurrentTarget = { Target, TargetSocket };
+			const FTargetInfo CurrentTarget = { Target, Sockets[SocketIndex] };
 
 			//Skip already captured Target and Socket.
 			if (Context.CapturedTarget.Target == CurrentTarget)
@@ -170,7 +368,8 @@ void UWeightedTargetHandler::PerformPrimarySamplingPass(FFindTargetContext& Cont
 				continue;
 			}
 
-			FTargetContext TargetContext = CreateTargetContext(Context, CurrentTarget);
+			//Socket locations are shared by all instigators within the frame.
+			FTargetContext TargetContext = CreateTargetContext(Context, CurrentTarget, TargetManager.GetSocketLocation(Index, SocketIndex));
 
 			//Check if in view cone.
 			const float DeltaConeAngle = FMath::RadiansToDegrees(FMath::Acos(Context.ViewRotationMatrix.GetScaledAxis(EAxis::X) | TargetContext.Direction));
@@ -194,42 +393,57 @@ void UWeightedTargetHandler::PerformPrimarySamplingPass(FFindTargetContext& Cont
 			OutTargetsData.Add(TargetContext);
 		}
 	}
-}
 
-bool UWeightedTargetHandler::ShouldSkipTargetPrimaryPass(const FFindTargetContext& Context, const UTargetComponent* Target) const
-{
-	if (!IsTargetValid(Target))
+	if (Context.bTrackStats)
 	{
-		return true;
+		LOT_COUNTER_SET(PrimarySamplingCandidatesOut, OutTargetsData.Num());
 	}
+}
 
-	const AActor* const TargetActor = Target->GetOwner();
-
-	if (bRecentRenderCheck && !TargetActor->WasRecentlyRendered(RecentTolerance))
+bool UWeightedTargetHandler::ShouldSkipTargetPrimaryPass(const FFindTargetContext& Context, const FRegisteredTargetsData& TargetsData, int32 Index) const
+{
+	//Only the packed data is read here, the Target itself is validated once it passes.
+	if (!TargetsData.CanBeCaptured[Index] || TargetsData.SocketsNum[Index] == 0 || TargetsData.Owners[Index] == Context.Instigator->GetOwner())
 	{
 		return true;
 	}
 
-	if (bDistanceCheck)
+	if (bRecentRenderCheck)
 	{
-		//It'd be more correct to check the distance per socket, but this is faster.
-		const float DistanceSq = (Context.ViewLocation - TargetActor->GetActorLocation()).SizeSquared();
-		const float TargetCaptureRadius = GetTargetCaptureRadius(Target);
+		//Mirrors the hitch allowance of AActor::WasRecentlyRendered(). The packed render time may be a frame old, so one more frame is allowed.
+		//Targets passing the rough check are checked precisely in PerformPrimarySamplingPass().
+		const UWorld* const World = GetWorld();
+		const float Tolerance = FMath::Max(RecentTolerance, World->DeltaTimeSeconds + KINDA_SMALL_NUMBER) + World->DeltaTimeSeconds;
 
-		if (DistanceSq > FMath::Square(TargetCaptureRadius) || DistanceSq < FMath::Square(NearClipRadius))
+		if (World->TimeSince(TargetsData.LastRenderTimes[Index]) > Tolerance)
 		{
 			return true;
 		}
 	}
 
+	//The capture radius is already checked by the capture radius query.
+	if (bDistanceCheck && (Context.ViewLocation - TargetsData.Locations[Index]).SizeSquared() < FMath::Square(NearClipRadius))
+	{
+		return true;
+	}
+
 	return false;
 }
 
 void UWeightedTargetHandler::PerformSolverPass(FFindTargetContext& Context, TArray<FTargetContext>& InOutTargetsData)
 {
-	for (FTargetContext& TargetContext : InOutTargetsData)
+	CONDITIONAL_SCOPE_CYCLE_COUNTER(STAT_LOT_Solver, Context.bTrackStats);
+
+	if (CanUseBatchedSolver())
 	{
-		TargetContext.Weight = CalculateTargetWeight(Context, TargetContext);
+		MakeSolverParams(Context).Solve(InOutTargetsData);
+	}
+	else
+	{
+		for (FTargetContext& TargetContext : InOutTargetsData)
+		{
+			TargetContext.Weight = CalculateTargetWeight(Context, TargetContext);
+		}
 	}
 }
 
@@ -269,15 +483,65 @@ float UWeightedTargetHandler::CalculateTargetWeight_Implementation(const FFindTa
 
 		if (TargetPriorityWeight > UE_KINDA_SMALL_NUMBER)
 		{
-			ApplyFactor(TargetPriorityWeight, TargetContext.Target->Priority);
+			ApplyFactor(TargetPriorityWeight, TargetContext.Priority);
 		}
 	}
 
 	return OutWeight;
 }
 
+bool UWeightedTargetHandler::CanUseBatchedSolver() const
+{
+	if (GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UWeightedTargetHandler, CalculateTargetWeight)))
+	{
+		return false;
+	}
+
+	//Native overrides of CalculateTargetWeight_Implementation() can't be detected through reflection, so native subclasses have to opt in.
+	const UClass* NativeClass = GetClass();
+
+	while (NativeClass && !NativeClass->HasAnyClassFlags(CLASS_Native))
+	{
+		NativeClass = NativeClass->GetSuperClass();
+	}
+
+	return NativeClass == UWeightedTargetHandler::StaticClass();
+}
+
+FWeightedTargetSolverParams UWeightedTargetHandler::MakeSolverParams(const FFindTargetContext& Context) const
+{
+	FWeightedTargetSolverParams Params;
+	Params.SolverViewDirection = FVector3f(Context.SolverViewDirection);
+	Params.MinimumFactorThreshold = MinimumFactorThreshold;
+	Params.InvDistanceMaxFactorSq = 1.f / FMath::Max(FMath::Square(DistanceMaxFactor), UE_KINDA_SMALL_NUMBER);
+	Params.InvDeltaAngleMaxFactor = 1.f / FMath::Max(DeltaAngleMaxFactor, UE_KINDA_SMALL_NUMBER);
+	Params.InvPlayerInputAngularRange = 1.f / FMath::Max(PlayerInputAngularRange, UE_KINDA_SMALL_NUMBER);
+
+	const float WeightSum = DistanceWeight + DeltaAngleWeight + PlayerInputWeight + TargetPriorityWeight;
+
+	if (!FMath::IsNearlyZero(WeightSum))
+	{
+		const float WeightNormalizer = PureDefaultWeight / WeightSum;
+
+		auto GetFactorScale = [WeightNormalizer](float Weight)
+			{
+				return Weight > UE_KINDA_SMALL_NUMBER ? Weight * WeightNormalizer : 0.f;
+			};
+
+		Params.DistanceScale = GetFactorScale(DistanceWeight);
+		Params.DeltaAngleScale = GetFactorScale(DeltaAngleWeight);
+		Params.PlayerInputScale = Context.Mode == EFindTargetContextMode::Switch ? GetFactorScale(PlayerInputWeight) : 0.f;
+		Params.PriorityScale = GetFactorScale(TargetPriorityWeight);
+	}
+
+	return Params;
+}
+
 FFindTargetRequestResponse UWeightedTargetHandler::PerformSecondarySamplingPass(FFindTargetContext& Context, TArray<FTargetContext>& InTargetsData)
 {
+	SCOPE_CYCLE_COUNTER(STAT_LOT_SecondarySampling);
+	LOT_COUNTER_SET(SecondarySamplingCandidatesIn, InTargetsData.Num());
+
 	FFindTargetRequestResponse OutResponse;
 
 	if (Context.RequestParams.bGenerateDetailedResponse)
@@ -294,24 +558,37 @@ FFindTargetRequestResponse UWeightedTargetHandler::PerformSecondarySamplingPass(
 
 		OutResponse.Payload = GenerateDetailedResponse(Context, InTargetsData);
 	}
+	else if (bLineOfSightCheck && bAsyncSecondarySampling && Context.bAllowDeferredResponse)
+	{
+		PerformDeferredSecondarySamplingPass(Context, InTargetsData);
+	}
 	else
 	{
-		const auto* const FoundTargetContext = InTargetsData.FindByPredicate([this, &Context](const FTargetContext& TargetContext)
-			{
-				return !ShouldSkipTargetSecondaryPass(Context, TargetContext);
-			});
+		//Pop Targets in weight order until one passes, most of the time it's the first one.
+		FTargetContext TargetContext;
 
-		if (FoundTargetContext)
+		while (InTargetsData.Num() > 0)
 		{
-			OutResponse.Target = FoundTargetContext->Target;
+			InTargetsData.HeapPop(TargetContext, FTargetContextWeightPredicate(), false);
+
+			if (!ShouldSkipTargetSecondaryPass(Context, TargetContext))
+			{
+				OutResponse.Target = TargetContext.Target;
+				break;
+			}
 		}
 	}
 
 	return OutResponse;
 }
 
-bool UWeightedTargetHandler::ShouldSkipTargetSecondaryPass(const FFindTargetContext& Context, const FTargetContext& TargetContext) const
+bool UWeightedTargetHandler::ShouldSkipTargetSecondaryPass(const FFindTargetContext& Context, const FTargetContext& TargetContext, bool bCheckLineOfSight) const
 {
+	if (Context.bTrackStats)
+	{
+		LOT_COUNTER_ADD(SecondarySamplingCandidatesTested, 1);
+	}
+
 	if (ShouldSkipTargetCustom(Context, TargetContext))
 	{
 		return true;
@@ -322,7 +599,7 @@ bool UWeightedTargetHandler::ShouldSkipTargetSecondaryPass(const FFindTargetCont
 		return true;
 	}
 
-	if (bLineOfSightCheck && !LineOfSightTrace(Context.ViewLocation, TargetContext.Location, TargetContext.Target->GetOwner()))
+	if (bCheckLineOfSight && bLineOfSightCheck && !LineOfSightTrace(Context.ViewLocation, TargetContext.Location, TargetContext.Target->GetOwner()))
 	{
 		return true;
 	}
@@ -330,8 +607,122 @@ bool UWeightedTargetHandler::ShouldSkipTargetSecondaryPass(const FFindTargetCont
 	return false;
 }
 
+void UWeightedTargetHandler::PerformDeferredSecondarySamplingPass(FFindTargetContext& Context, TArray<FTargetContext>& InTargetsData)
+{
+	//The rest of the heap is kept for the next batches, in case the best candidates are occluded.
+	DeferredContext = Context;
+	DeferredRemainingCandidates = MoveTemp(InTargetsData);
+	TraceNextDeferredBatch();
+}
+
+bool UWeightedTargetHandler::TraceNextDeferredBatch()
+{
+	UWorld* const World = GetWorld();
+
+	if (!World)
+	{
+		return false;
+	}
+
+	FTargetContext TargetContext;
+
+	while (DeferredRemainingCandidates.Num() > 0 && DeferredCandidates.Num() < AsyncSecondarySamplingBatchSize)
+	{
+		DeferredRemainingCandidates.HeapPop(TargetContext, FTargetContextWeightPredicate(), false);
+
+		//Targets of the next batches might have become invalid since the request.
+		if (IsTargetValid(TargetContext.Target.TargetComponent) && !ShouldSkipTargetSecondaryPass(DeferredContext, TargetContext, /*bCheckLineOfSight*/false))
+		{
+			DeferredCandidates.Add(TargetContext);
+		}
+	}
+
+	if (DeferredCandidates.Num() > 0)
+	{
+		DeferredVisibility.Init(false, DeferredCandidates.Num());
+		DeferredTraceHandles.Reserve(DeferredCandidates.Num());
+
+		for (const FTargetContext& Candidate : DeferredCandidates)
+		{
+			const FCollisionQueryParams QueryParams = MakeLineOfSightQueryParams(Candidate.Target->GetOwner());
+			DeferredTraceHandles.Add(World->AsyncLineTraceByChannel(EAsyncTraceType::Single, DeferredContext.ViewLocation, Candidate.Location, TraceCollisionChannel, QueryParams, FCollisionResponseParams::DefaultResponseParam, &DeferredTraceDelegate));
+		}
+
+		DeferredPendingTracesNum = DeferredCandidates.Num();
+		LOT_COUNTER_ADD(LineOfSightTraces, DeferredCandidates.Num());
+	}
+
+	return DeferredPendingTracesNum > 0;
+}
+
+void UWeightedTargetHandler::OnDeferredLineOfSightTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	const int32 Index = DeferredTraceHandles.IndexOfByKey(TraceHandle);
+
+	//The batch might have been cancelled.
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	DeferredTraceHandles[Index].Invalidate();
+	DeferredVisibility[Index] = !TraceDatum.OutHits.ContainsByPredicate([](const FHitResult& HitResult)
+		{
+			return HitResult.bBlockingHit;
+		});
+
+	if (--DeferredPendingTracesNum == 0)
+	{
+		ResolveDeferredSecondarySampling();
+	}
+}
+
+void UWeightedTargetHandler::ResolveDeferredSecondarySampling()
+{
+	LOT_SCOPED_EVENT(WTH_ResolveDeferredSecondarySampling);
+
+	FFindTargetRequestResponse Response;
+
+	for (int32 i = 0; i < DeferredCandidates.Num(); ++i)
+	{
+		//Targets might have become invalid during the frame.
+		if (DeferredVisibility[i] && IsTargetValid(DeferredCandidates[i].Target.TargetComponent))
+		{
+			Response.Target = DeferredCandidates[i].Target;
+			break;
+		}
+	}
+
+	if (!Response.Target.TargetComponent)
+	{
+		DeferredCandidates.Reset();
+		DeferredTraceHandles.Reset();
+		DeferredVisibility.Reset();
+
+		//The whole batch is occluded, so the next best candidates are traced, as the sync pass would do.
+		if (TraceNextDeferredBatch())
+		{
+			return;
+		}
+	}
+
+	CancelDeferredSecondarySampling();
+	CompleteOrDeferAsyncRequest(Response);
+}
+
+void UWeightedTargetHandler::CancelDeferredSecondarySampling()
+{
+	DeferredContext = FFindTargetContext();
+	DeferredRemainingCandidates.Reset();
+	DeferredCandidates.Reset();
+	DeferredTraceHandles.Reset();
+	DeferredVisibility.Reset();
+	DeferredPendingTracesNum = 0;
+}
+
 UWeightedTargetHandlerDetailedResponse* UWeightedTargetHandler::GenerateDetailedResponse(const FFindTargetContext& Context, TArray<FTargetContext>& InTargetsData)
 {
+	LOT_COUNTER_ADD(DetailedResponses, 1);
 	auto* const Response = NewObject<UWeightedTargetHandlerDetailedResponse>(this, FName(TEXT("WeightedTargetHandler_DetailedResponse")), RF_StrongRefOnFrame | RF_Transient);
 
 	if (Response)
@@ -343,6 +734,338 @@ UWeightedTargetHandlerDetailedResponse* UWeightedTargetHandler::GenerateDetailed
 	return Response;
 }
 
+/*******************************************************************************************/
+/**************************** Switch Neighbour Graph ***************************************/
+/*******************************************************************************************/
+
+bool UWeightedTargetHandler::TryFindSwitchNeighbour(const FFindTargetRequestParams& RequestParams, FFindTargetRequestResponse& OutResponse)
+{
+	if (!bSwitchNeighbourGraph || RequestParams.bGenerateDetailedResponse)
+	{
+		return false;
+	}
+
+	const ULockOnTargetComponent* const LockOn = GetLockOnTargetComponent();
+
+	if (!GetWorld() || !LockOn->IsTargetLocked())
+	{
+		return false;
+	}
+
+	const FVector2D InputDirection = RequestParams.PlayerInput.GetSafeNormal();
+
+	if (InputDirection.IsZero())
+	{
+		return false;
+	}
+
+	const FFindTargetContext Context = CreateFindTargetContext(EFindTargetContextMode::Switch, RequestParams);
+
+	//Built lazily, so a moving player doesn't pay for it without switching.
+	if (IsSwitchNeighbourGraphOutdated(Context))
+	{
+		RebuildSwitchNeighbourGraph(Context);
+	}
+
+	//Targets might have changed since the graph was built, so an empty or invalid neighbour needs the full search.
+	const FTargetInfo& Neighbour = SwitchNeighbours[GetSwitchNeighbourDirectionIndex(InputDirection)];
+
+	if (!Neighbour.TargetComponent || !LockOn->CanTargetBeCaptured(Neighbour))
+	{
+		return false;
+	}
+
+	//Only the chosen neighbour is traced, as the visibility might have changed since the graph was built.
+	if (bLineOfSightCheck && !LineOfSightTrace(Context.ViewLocation, Neighbour->GetSocketLocation(Neighbour.Socket), Neighbour->GetOwner()))
+	{
+		return false;
+	}
+
+	OutResponse.Target = Neighbour;
+	return true;
+}
+
+bool UWeightedTargetHandler::IsSwitchNeighbourGraphOutdated(const FFindTargetContext& Context) const
+{
+	const float MovementThresholdSq = FMath::Square(SwitchNeighbourGraphMovementThreshold);
+
+	return !(SwitchNeighbourGraphTarget == Context.CapturedTarget.Target)
+		|| GetWorld()->GetTimeSeconds() - SwitchNeighbourGraphTime > SwitchNeighbourGraphInterval
+		|| FVector::DistSquared(Context.ViewLocation, SwitchNeighbourGraphViewLocation) > MovementThresholdSq
+		|| FVector::DistSquared(Context.CapturedTarget.Location, SwitchNeighbourGraphTargetLocation) > MovementThresholdSq;
+}
+
+void UWeightedTargetHandler::RebuildSwitchNeighbourGraph(FFindTargetContext Context)
+{
+	LOT_SCOPED_EVENT(WTH_RebuildSwitchNeighbourGraph);
+
+	ResetSwitchNeighbourGraph();
+
+	SwitchNeighbourGraphTarget = Context.CapturedTarget.Target;
+	SwitchNeighbourGraphTime = GetWorld()->GetTimeSeconds();
+	SwitchNeighbourGraphViewLocation = Context.ViewLocation;
+	SwitchNeighbourGraphTargetLocation = Context.CapturedTarget.Location;
+
+	//The rebuild isn't a find request, so it's kept out of the pass stats.
+	Context.bTrackStats = false;
+
+	//Candidates are gathered regardless of the input direction.
+	TArray<FTargetContext> Candidates;
+	Context.Mode = EFindTargetContextMode::Find;
+	PerformPrimarySamplingPass(Context, /*out*/Candidates);
+	Context.Mode = EFindTargetContextMode::Switch;
+
+	//Candidates are projected onto the screen plane only once.
+	for (FTargetContext& Candidate : Candidates)
+	{
+		CalcDeltaAngle2D(Context, Candidate);
+	}
+
+	//Each candidate is tested by the secondary pass at most once. -1 if not tested yet.
+	TArray<int8> SecondaryPassResults;
+	SecondaryPassResults.Init(-1, Candidates.Num());
+
+	TArray<FTargetContext> DirectionCandidates;
+	TArray<int32> DirectionCandidateIndices;
+	TArray<TPair<float, int32>> WeightOrder;
+
+	for (int32 DirectionIndex = 0; DirectionIndex < UE_ARRAY_COUNT(SwitchNeighbours); ++DirectionIndex)
+	{
+		const float DirectionAngle = DirectionIndex * UE_PI * 0.25f;
+		Context.PlayerInputDirection = FVector2D(FMath::Cos(DirectionAngle), FMath::Sin(DirectionAngle));
+
+		DirectionCandidates.Reset();
+		DirectionCandidateIndices.Reset();
+
+		for (int32 i = 0; i < Candidates.Num(); ++i)
+		{
+			FTargetContext Candidate = Candidates[i];
+			Candidate.DeltaAngle2D = FMath::RadiansToDegrees(FMath::Acos(Candidate.DeltaDirection2D | Context.PlayerInputDirection));
+
+			if (Candidate.DeltaAngle2D <= PlayerInputAngularRange)
+			{
+				DirectionCandidates.Add(Candidate);
+				DirectionCandidateIndices.Add(i);
+			}
+		}
+
+		if (DirectionCandidates.IsEmpty())
+		{
+			continue;
+		}
+
+		PerformSolverPass(Context, /*inout*/DirectionCandidates);
+
+		WeightOrder.Reset();
+
+		for (int32 i = 0; i < DirectionCandidates.Num(); ++i)
+		{
+			WeightOrder.Emplace(DirectionCandidates[i].Weight, i);
+		}
+
+		WeightOrder.Sort();
+
+		//Test candidates in weight order until one passes, most of the time it's the first one.
+		for (const TPair<float, int32>& Entry : WeightOrder)
+		{
+			const FTargetContext& Candidate = DirectionCandidates[Entry.Value];
+			int8& SecondaryPassResult = SecondaryPassResults[DirectionCandidateIndices[Entry.Value]];
+
+			if (SecondaryPassResult < 0)
+			{
+				SecondaryPassResult = ShouldSkipTargetSecondaryPass(Context, Candidate, /*bCheckLineOfSight*/false) ? 0 : 1;
+			}
+
+			if (SecondaryPassResult > 0)
+			{
+				SwitchNeighbours[DirectionIndex] = Candidate.Target;
+				break;
+			}
+		}
+	}
+}
+
+void UWeightedTargetHandler::ResetSwitchNeighbourGraph()
+{
+	for (FTargetInfo& Neighbour : SwitchNeighbours)
+	{
+		Neighbour = FTargetInfo::NULL_TARGET;
+	}
+
+	SwitchNeighbourGraphTarget = FTargetInfo::NULL_TARGET;
+}
+
+int32 UWeightedTargetHandler::GetSwitchNeighbourDirectionIndex(const FVector2D& Direction)
+{
+	const float Angle = FMath::Atan2(Direction.Y, Direction.X);
+	return FMath::RoundToInt32(Angle / (UE_PI * 0.25f)) & 7;
+}
+
+/*******************************************************************************************/
+/********************************* Async Solver ********************************************/
+/*******************************************************************************************/
+
+void UWeightedTargetHandler::LaunchAsyncSolver(FFindTargetContext& Context, TArray<FTargetContext>&& TargetsData)
+{
+	LOT_SCOPED_EVENT(WTH_LaunchAsyncSolver);
+
+	AsyncSolverContext = Context;
+	AsyncSolverTargets.Reset(TargetsData.Num());
+
+	for (const FTargetContext& TargetContext : TargetsData)
+	{
+		AsyncSolverTargets.Add(TargetContext.Target.TargetComponent);
+	}
+
+	//Only plain data is accessed by the task.
+	AsyncSolverTask = UE::Tasks::Launch(UE_SOURCE_LOCATION,
+		[SolverParams = MakeSolverParams(Context), TargetsData = MoveTemp(TargetsData), bSort = Context.RequestParams.bGenerateDetailedResponse]() mutable
+		{
+			LOT_SCOPED_EVENT(WTH_AsyncSolver);
+
+			SolverParams.Solve(TargetsData);
+
+			if (bSort)
+			{
+				TargetsData.Sort(FTargetContextWeightPredicate());
+			}
+			else
+			{
+				TargetsData.Heapify(FTargetContextWeightPredicate());
+			}
+
+			return MoveTemp(TargetsData);
+		});
+
+	AsyncSolverPollHandle = GetWorld()->GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateUObject(this, &ThisClass::PollAsyncSolver));
+}
+
+void UWeightedTargetHandler::PollAsyncSolver()
+{
+	//The request might have been cancelled.
+	if (!AsyncSolverTask.IsValid() || !AsyncRequestHandle.IsValid())
+	{
+		return;
+	}
+
+	if (!AsyncSolverTask.IsCompleted())
+	{
+		AsyncSolverPollHandle = GetWorld()->GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateUObject(this, &ThisClass::PollAsyncSolver));
+		return;
+	}
+
+	LOT_SCOPED_EVENT(WTH_Pass_SecondarySampling);
+
+	TArray<FTargetContext> TargetsData = MoveTemp(AsyncSolverTask.GetResult());
+	FFindTargetContext Context = MoveTemp(AsyncSolverContext);
+	AsyncSolverTask = {};
+	AsyncSolverContext = FFindTargetContext();
+	AsyncSolverTargets.Reset();
+
+	//Targets might have become invalid in the meantime.
+	const int32 RemovedNum = TargetsData.RemoveAll([this](const FTargetContext& TargetContext)
+		{
+			return !IsTargetValid(TargetContext.Target.TargetComponent);
+		});
+
+	if (RemovedNum > 0 && !Context.RequestParams.bGenerateDetailedResponse)
+	{
+		TargetsData.Heapify(FTargetContextWeightPredicate());
+	}
+
+	CompleteOrDeferAsyncRequest(PerformSecondarySamplingPass(Context, TargetsData));
+}
+
+/*******************************************************************************************/
+/******************************* Batched Solver ********************************************/
+/*******************************************************************************************/
+
+namespace
+{
+	//Abramowitz and Stegun 4.4.45 acos approximation for [-1, 1]. The max error is ~6.7e-5 rad.
+	FORCEINLINE VectorRegister4Float VectorAcosApprox(const VectorRegister4Float& X)
+	{
+		const VectorRegister4Float AbsX = VectorMin(VectorAbs(X), GlobalVectorConstants::FloatOne);
+
+		VectorRegister4Float Poly = VectorSetFloat1(-0.0187293f);
+		Poly = VectorMultiplyAdd(Poly, AbsX, VectorSetFloat1(0.0742610f));
+		Poly = VectorMultiplyAdd(Poly, AbsX, VectorSetFloat1(-0.2121144f));
+		Poly = VectorMultiplyAdd(Poly, AbsX, VectorSetFloat1(1.5707288f));
+
+		const VectorRegister4Float Result = VectorMultiply(Poly, VectorSqrt(VectorSubtract(GlobalVectorConstants::FloatOne, AbsX)));
+
+		//acos(-x) = PI - acos(x).
+		return VectorSelect(VectorCompareLT(X, GlobalVectorConstants::FloatZero), VectorSubtract(VectorSetFloat1(UE_PI), Result), Result);
+	}
+
+	//Vectorized FMath::Clamp(Ratio, MinimumFactorThreshold, 1.f).
+	FORCEINLINE VectorRegister4Float VectorClampFactor(const VectorRegister4Float& Ratio, const VectorRegister4Float& MinFactor)
+	{
+		return VectorMin(VectorMax(Ratio, MinFactor), GlobalVectorConstants::FloatOne);
+	}
+}
+
+void FWeightedTargetSolverParams::Solve(TArrayView<FTargetContext> TargetsData) const
+{
+	constexpr int32 BatchSize = 4;
+
+	const VectorRegister4Float ViewX = VectorSetFloat1(SolverViewDirection.X);
+	const VectorRegister4Float ViewY = VectorSetFloat1(SolverViewDirection.Y);
+	const VectorRegister4Float ViewZ = VectorSetFloat1(SolverViewDirection.Z);
+
+	const VectorRegister4Float DistanceScaleV = VectorSetFloat1(DistanceScale);
+	const VectorRegister4Float DeltaAngleScaleV = VectorSetFloat1(DeltaAngleScale);
+	const VectorRegister4Float PlayerInputScaleV = VectorSetFloat1(PlayerInputScale);
+	const VectorRegister4Float PriorityScaleV = VectorSetFloat1(PriorityScale);
+
+	const VectorRegister4Float InvDistanceMaxFactorSqV = VectorSetFloat1(InvDistanceMaxFactorSq);
+	const VectorRegister4Float DeltaAngleRatioV = VectorSetFloat1(FMath::RadiansToDegrees(1.f) * InvDeltaAngleMaxFactor);
+	const VectorRegister4Float InvPlayerInputAngularRangeV = VectorSetFloat1(InvPlayerInputAngularRange);
+	const VectorRegister4Float MinFactorV = VectorSetFloat1(MinimumFactorThreshold);
+
+	alignas(16) float DirectionsX[BatchSize];
+	alignas(16) float DirectionsY[BatchSize];
+	alignas(16) float DirectionsZ[BatchSize];
+	alignas(16) float DistancesSq[BatchSize];
+	alignas(16) float DeltaAngles2D[BatchSize];
+	alignas(16) float Priorities[BatchSize];
+	alignas(16) float Weights[BatchSize];
+
+	for (int32 First = 0; First < TargetsData.Num(); First += BatchSize)
+	{
+		const int32 BatchNum = FMath::Min(BatchSize, TargetsData.Num() - First);
+
+		//Transpose the batch. The tail is padded with the last Target.
+		for (int32 Lane = 0; Lane < BatchSize; ++Lane)
+		{
+			const FTargetContext& TargetContext = TargetsData[First + FMath::Min(Lane, BatchNum - 1)];
+			DirectionsX[Lane] = static_cast<float>(TargetContext.Direction.X);
+			DirectionsY[Lane] = static_cast<float>(TargetContext.Direction.Y);
+			DirectionsZ[Lane] = static_cast<float>(TargetContext.Direction.Z);
+			DistancesSq[Lane] = TargetContext.DistanceSq;
+			DeltaAngles2D[Lane] = TargetContext.DeltaAngle2D;
+			Priorities[Lane] = TargetContext.Priority;
+		}
+
+		VectorRegister4Float Dot = VectorMultiply(VectorLoadAligned(DirectionsX), ViewX);
+		Dot = VectorMultiplyAdd(VectorLoadAligned(DirectionsY), ViewY, Dot);
+		Dot = VectorMultiplyAdd(VectorLoadAligned(DirectionsZ), ViewZ, Dot);
+
+		//Disabled factors have zero scale.
+		VectorRegister4Float Weight = VectorMultiply(DistanceScaleV, VectorClampFactor(VectorMultiply(VectorLoadAligned(DistancesSq), InvDistanceMaxFactorSqV), MinFactorV));
+		Weight = VectorMultiplyAdd(DeltaAngleScaleV, VectorClampFactor(VectorMultiply(VectorAcosApprox(Dot), DeltaAngleRatioV), MinFactorV), Weight);
+		Weight = VectorMultiplyAdd(PlayerInputScaleV, VectorClampFactor(VectorMultiply(VectorLoadAligned(DeltaAngles2D), InvPlayerInputAngularRangeV), MinFactorV), Weight);
+		Weight = VectorMultiplyAdd(PriorityScaleV, VectorClampFactor(VectorLoadAligned(Priorities), MinFactorV), Weight);
+
+		VectorStoreAligned(Weight, Weights);
+
+		for (int32 Lane = 0; Lane < BatchNum; ++Lane)
+		{
+			TargetsData[First + Lane].Weight = Weights[Lane];
+		}
+	}
+}
+
 /*******************************************************************************************/
 /*********************************** Helpers ***********************************************/
 /*******************************************************************************************/
@@ -414,11 +1137,18 @@ FFindTargetContext UWeightedTargetHandler::CreateFindTargetContext(EFindTargetCo
 }
 
 FTargetContext UWeightedTargetHandler::CreateTargetContext(const FFindTargetContext& Context, const FTargetInfo& InTarget)
+{
+	check(InTarget.TargetComponent);
+	return CreateTargetContext(Context, InTarget, InTarget->GetSocketLocation(InTarget.Socket));
+}
+
+FTargetContext UWeightedTargetHandler::CreateTargetContext(const FFindTargetContext& Context, const FTargetInfo& InTarget, const FVector& SocketLocation)
 {
 	check(InTarget.TargetComponent);
 
 	FTargetContext TargetContext{ InTarget };
-	TargetContext.Location = InTarget->GetSocketLocation(InTarget.Socket);
+	TargetContext.Location = SocketLocation;
+	TargetContext.Priority = InTarget->Priority;
 	const FVector Delta = TargetContext.Location - Context.ViewLocation;
 	TargetContext.DistanceSq = Delta.SizeSquared();
 
@@ -487,6 +1217,49 @@ void UWeightedTargetHandler::GetPointOfView_Implementation(FVector& OutLocation,
 	}
 }
 
+/*******************************************************************************************/
+/*********************************  Distance  **********************************************/
+/*******************************************************************************************/
+
+void UWeightedTargetHandler::BindDistanceCheckEvents(const UTargetComponent* Target)
+{
+	UnbindDistanceCheckEvents();
+
+	const AActor* const Owner = GetLockOnTargetComponent()->GetOwner();
+	const AActor* const TargetOwner = Target ? Target->GetOwner() : nullptr;
+
+	if (Owner && Owner->GetRootComponent() && TargetOwner && TargetOwner->GetRootComponent())
+	{
+		OwnerRootComponent = Owner->GetRootComponent();
+		TargetRootComponent = TargetOwner->GetRootComponent();
+		OwnerTransformUpdatedHandle = OwnerRootComponent->TransformUpdated.AddUObject(this, &ThisClass::OnDistanceCheckTransformUpdated);
+		TargetTransformUpdatedHandle = TargetRootComponent->TransformUpdated.AddUObject(this, &ThisClass::OnDistanceCheckTransformUpdated);
+	}
+}
+
+void UWeightedTargetHandler::UnbindDistanceCheckEvents()
+{
+	if (OwnerRootComponent.IsValid())
+	{
+		OwnerRootComponent->TransformUpdated.Remove(OwnerTransformUpdatedHandle);
+	}
+
+	if (TargetRootComponent.IsValid())
+	{
+		TargetRootComponent->TransformUpdated.Remove(TargetTransformUpdatedHandle);
+	}
+
+	OwnerRootComponent.Reset();
+	TargetRootComponent.Reset();
+	OwnerTransformUpdatedHandle.Reset();
+	TargetTransformUpdatedHandle.Reset();
+}
+
+void UWeightedTargetHandler::OnDistanceCheckTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	bDistanceCheckPending = true;
+}
+
 /*******************************************************************************************/
 /*******************************  Line Of Sight  *******************************************/
 /*******************************************************************************************/
@@ -519,12 +1292,54 @@ bool UWeightedTargetHandler::LineOfSightTrace(const FVector& From, const FVector
 
 	if (UWorld* const World = GetWorld())
 	{
+		LOT_COUNTER_ADD(LineOfSightTraces, 1);
 		FHitResult HitRes;
-		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT_NAME_ONLY(LockOnTargetTrace));
-		QueryParams.AddIgnoredActor(TargetToIgnore);
-		QueryParams.AddIgnoredActor(GetLockOnTargetComponent()->GetOwner());
-		bOutSuccess = !World->LineTraceSingleByChannel(HitRes, From, To, TraceCollisionChannel, QueryParams);
+		bOutSuccess = !World->LineTraceSingleByChannel(HitRes, From, To, TraceCollisionChannel, MakeLineOfSightQueryParams(TargetToIgnore));
 	}
 
 	return bOutSuccess;
 }
+
+FCollisionQueryParams UWeightedTargetHandler::MakeLineOfSightQueryParams(const AActor* const TargetToIgnore) const
+{
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT_NAME_ONLY(LockOnTargetTrace));
+	QueryParams.AddIgnoredActor(TargetToIgnore);
+	QueryParams.AddIgnoredActor(GetLockOnTargetComponent()->GetOwner());
+	return QueryParams;
+}
+
+void UWeightedTargetHandler::RequestAsyncLineOfSightTrace(const FVector& From, const FVector& To, const AActor* const TargetToIgnore)
+{
+	UWorld* const World = GetWorld();
+
+	if (World && !LineOfSightTraceHandle.IsValid())
+	{
+		LOT_COUNTER_ADD(LineOfSightTraces, 1);
+		LineOfSightTraceHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, From, To, TraceCollisionChannel, MakeLineOfSightQueryParams(TargetToIgnore), FCollisionResponseParams::DefaultResponseParam, &LineOfSightTraceDelegate);
+	}
+}
+
+void UWeightedTargetHandler::OnAsyncLineOfSightTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	//The Target might have been unlocked while the trace was in flight.
+	if (TraceHandle != LineOfSightTraceHandle)
+	{
+		return;
+	}
+
+	LineOfSightTraceHandle.Invalidate();
+
+	const bool bSuccess = !TraceDatum.OutHits.ContainsByPredicate([](const FHitResult& HitResult)
+		{
+			return HitResult.bBlockingHit;
+		});
+
+	if (bSuccess)
+	{
+		StopLineOfSightTimer();
+	}
+	else
+	{
+		StartLineOfSightTimer();
+	}
+}
@@ -0,0 +1,258 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#include "TargetInfoNetSerializer.h"
+
+#if UE_WITH_IRIS
+
+#include "LockOnTargetTypes.h"
+#include "TargetComponent.h"
+#include "TargetManager.h"
+
+#include "GameFramework/Actor.h"
+#include "Iris/Core/NetObjectReference.h"
+#include "Iris/ReplicationState/PropertyNetSerializerInfoRegistry.h"
+#include "Iris/Serialization/NetBitStreamReader.h"
+#include "Iris/Serialization/NetBitStreamUtil.h"
+#include "Iris/Serialization/NetBitStreamWriter.h"
+#include "Iris/Serialization/NetReferenceCollector.h"
+#include "Iris/Serialization/NetSerializerDelegates.h"
+#include "Iris/Serialization/ObjectNetSerializer.h"
+
+namespace UE::Net
+{
+
+struct FTargetInfoNetSerializer
+{
+	static constexpr uint32 Version = 0;
+	static constexpr bool bHasCustomNetReference = true;
+
+	struct FQuantizedType
+	{
+		FNetObjectReference OwnerReference;
+		uint32 SocketIndex;
+		uint8 SocketIndexWidthCode;
+		uint8 bIsValid;
+	};
+
+	typedef FTargetInfo SourceType;
+	typedef FQuantizedType QuantizedType;
+	typedef FTargetInfoNetSerializerConfig ConfigType;
+
+	static const ConfigType DefaultConfig;
+
+	static void Serialize(FNetSerializationContext& Context, const FNetSerializeArgs& Args);
+	static void Deserialize(FNetSerializationContext& Context, const FNetDeserializeArgs& Args);
+
+	static void Quantize(FNetSerializationContext& Context, const FNetQuantizeArgs& Args);
+	static void Dequantize(FNetSerializationContext& Context, const FNetDequantizeArgs& Args);
+
+	static bool IsEqual(FNetSerializationContext& Context, const FNetIsEqualArgs& Args);
+	static bool Validate(FNetSerializationContext& Context, const FNetValidateArgs& Args);
+
+	static void CollectNetReferences(FNetSerializationContext& Context, const FNetCollectReferencesArgs& Args);
+
+private:
+
+	class FNetSerializerRegistryDelegates final : private UE::Net::FNetSerializerRegistryDelegates
+	{
+	public:
+
+		virtual ~FNetSerializerRegistryDelegates();
+
+	private:
+
+		virtual void OnPreFreezeNetSerializerRegistry() override;
+	};
+
+	//The owner is serialized by the object serializer, as the mapping of components is broken. See FTargetInfo::NetSerialize().
+	static const FNetSerializer* ObjectNetSerializer;
+	static FObjectNetSerializerConfig ObjectNetSerializerConfig;
+
+	static FTargetInfoNetSerializer::FNetSerializerRegistryDelegates NetSerializerRegistryDelegates;
+};
+
+UE_NET_IMPLEMENT_SERIALIZER(FTargetInfoNetSerializer);
+
+const FTargetInfoNetSerializer::ConfigType FTargetInfoNetSerializer::DefaultConfig;
+const FNetSerializer* FTargetInfoNetSerializer::ObjectNetSerializer = &UE_NET_GET_SERIALIZER(FObjectNetSerializer);
+FObjectNetSerializerConfig FTargetInfoNetSerializer::ObjectNetSerializerConfig;
+FTargetInfoNetSerializer::FNetSerializerRegistryDelegates FTargetInfoNetSerializer::NetSerializerRegistryDelegates;
+
+void FTargetInfoNetSerializer::Serialize(FNetSerializationContext& Context, const FNetSerializeArgs& Args)
+{
+	//[ IsTargetValid? ]~[ NetObjectReference ][ IsDefaultSocket? ]~[ Socket Idx Width Code ][ Socket Idx ]
+
+	const QuantizedType& Value = *reinterpret_cast<const QuantizedType*>(Args.Source);
+	FNetBitStreamWriter* const Writer = Context.GetBitStreamWriter();
+
+	if (Writer->WriteBool(Value.bIsValid))
+	{
+		FNetSerializeArgs ObjectArgs = Args;
+		ObjectArgs.Source = NetSerializerValuePointer(&Value.OwnerReference);
+		ObjectArgs.NetSerializerConfig = NetSerializerConfigParam(&ObjectNetSerializerConfig);
+		ObjectNetSerializer->Serialize(Context, ObjectArgs);
+
+		if (!Writer->WriteBool(Value.SocketIndex == 0))
+		{
+			Writer->WriteBits(Value.SocketIndexWidthCode, FTargetInfo::SocketIndexWidthCodeBits);
+
+			if (Value.SocketIndexWidthCode == FTargetInfo::SocketIndexWidthCodePacked)
+			{
+				WritePackedUint32(Writer, Value.SocketIndex);
+			}
+			else
+			{
+				Writer->WriteBits(Value.SocketIndex, Value.SocketIndexWidthCode + 1);
+			}
+		}
+	}
+}
+
+void FTargetInfoNetSerializer::Deserialize(FNetSerializationContext& Context, const FNetDeserializeArgs& Args)
+{
+	QuantizedType& Target = *reinterpret_cast<QuantizedType*>(Args.Target);
+	FNetBitStreamReader* const Reader = Context.GetBitStreamReader();
+
+	Target = QuantizedType();
+	Target.bIsValid = Reader->ReadBool();
+
+	if (Target.bIsValid)
+	{
+		FNetDeserializeArgs ObjectArgs = Args;
+		ObjectArgs.Target = NetSerializerValuePointer(&Target.OwnerReference);
+		ObjectArgs.NetSerializerConfig = NetSerializerConfigParam(&ObjectNetSerializerConfig);
+		ObjectNetSerializer->Deserialize(Context, ObjectArgs);
+
+		if (!Reader->ReadBool())
+		{
+			Target.SocketIndexWidthCode = static_cast<uint8>(Reader->ReadBits(FTargetInfo::SocketIndexWidthCodeBits));
+
+			if (Target.SocketIndexWidthCode == FTargetInfo::SocketIndexWidthCodePacked)
+			{
+				Target.SocketIndex = ReadPackedUint32(Reader);
+			}
+			else
+			{
+				Target.SocketIndex = Reader->ReadBits(Target.SocketIndexWidthCode + 1);
+			}
+		}
+	}
+}
+
+void FTargetInfoNetSerializer::Quantize(FNetSerializationContext& Context, const FNetQuantizeArgs& Args)
+{
+	const SourceType& Source = *reinterpret_cast<const SourceType*>(Args.Source);
+	QuantizedType& Target = *reinterpret_cast<QuantizedType*>(Args.Target);
+
+	Target = QuantizedType();
+	Target.bIsValid = IsValid(Source.TargetComponent);
+
+	if (Target.bIsValid)
+	{
+		const UObject* const TargetOwner = Source.TargetComponent->GetOwner();
+
+		FNetQuantizeArgs ObjectArgs = Args;
+		ObjectArgs.Source = NetSerializerValuePointer(&TargetOwner);
+		ObjectArgs.Target = NetSerializerValuePointer(&Target.OwnerReference);
+		ObjectArgs.NetSerializerConfig = NetSerializerConfigParam(&ObjectNetSerializerConfig);
+		ObjectNetSerializer->Quantize(Context, ObjectArgs);
+
+		Target.SocketIndex = Source.GetSocketIndex();
+		Target.SocketIndexWidthCode = static_cast<uint8>(FTargetInfo::GetSocketIndexWidthCode(Target.SocketIndex));
+	}
+}
+
+void FTargetInfoNetSerializer::Dequantize(FNetSerializationContext& Context, const FNetDequantizeArgs& Args)
+{
+	const QuantizedType& Source = *reinterpret_cast<const QuantizedType*>(Args.Source);
+	SourceType& Target = *reinterpret_cast<SourceType*>(Args.Target);
+
+	Target = FTargetInfo::NULL_TARGET;
+
+	if (Source.bIsValid)
+	{
+		UObject* TargetOwner = nullptr;
+
+		FNetDequantizeArgs ObjectArgs = Args;
+		ObjectArgs.Source = NetSerializerValuePointer(&Source.OwnerReference);
+		ObjectArgs.Target = NetSerializerValuePointer(&TargetOwner);
+		ObjectArgs.NetSerializerConfig = NetSerializerConfigParam(&ObjectNetSerializerConfig);
+		ObjectNetSerializer->Dequantize(Context, ObjectArgs);
+
+		//If the owner isn't mapped yet, the Target stays null until the reference is resolved.
+		if (UTargetComponent* const TargetComponent = UTargetManager::FindTargetComponent(Cast<AActor>(TargetOwner)))
+		{
+			const TArray<FName>& Sockets = TargetComponent->GetSockets();
+
+			//The index comes from the network, e.g. from a client RPC, so an invalid one results in the null Target without asserting.
+			if (Sockets.IsValidIndex(Source.SocketIndex))
+			{
+				Target.TargetComponent = TargetComponent;
+				Target.Socket = Sockets[Source.SocketIndex];
+			}
+		}
+	}
+}
+
+bool FTargetInfoNetSerializer::IsEqual(FNetSerializationContext& Context, const FNetIsEqualArgs& Args)
+{
+	if (Args.bStateIsQuantized)
+	{
+		const QuantizedType& Value0 = *reinterpret_cast<const QuantizedType*>(Args.Source0);
+		const QuantizedType& Value1 = *reinterpret_cast<const QuantizedType*>(Args.Source1);
+
+		return Value0.bIsValid == Value1.bIsValid
+			&& Value0.OwnerReference == Value1.OwnerReference
+			&& Value0.SocketIndex == Value1.SocketIndex;
+	}
+
+	return *reinterpret_cast<const SourceType*>(Args.Source0) == *reinterpret_cast<const SourceType*>(Args.Source1);
+}
+
+bool FTargetInfoNetSerializer::Validate(FNetSerializationContext& Context, const FNetValidateArgs& Args)
+{
+	const SourceType& Source = *reinterpret_cast<const SourceType*>(Args.Source);
+
+	//The owner must be replicated, otherwise it can't be referenced. See UTargetComponent::CanBeReferencedOverNetwork().
+	if (!IsValid(Source.TargetComponent))
+	{
+		return true;
+	}
+
+	const AActor* const TargetOwner = Source.TargetComponent->GetOwner();
+	return TargetOwner && TargetOwner->GetIsReplicated();
+}
+
+void FTargetInfoNetSerializer::CollectNetReferences(FNetSerializationContext& Context, const FNetCollectReferencesArgs& Args)
+{
+	const QuantizedType& Value = *reinterpret_cast<const QuantizedType*>(Args.Source);
+	FNetReferenceCollector& Collector = *reinterpret_cast<FNetReferenceCollector*>(Args.Collector);
+
+	if (Value.bIsValid && Value.OwnerReference.IsValid())
+	{
+		const FNetReferenceInfo ReferenceInfo(FNetReferenceInfo::EResolveType::ResolveOnClient);
+		Collector.Add(ReferenceInfo, Value.OwnerReference, Args.ChangeMaskInfo);
+	}
+}
+
+/********************************************************************
+ * Registration
+ ********************************************************************/
+
+static const FName PropertyNetSerializerRegistry_NAME_TargetInfo("TargetInfo");
+UE_NET_IMPLEMENT_NAMED_STRUCT_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_TargetInfo, FTargetInfoNetSerializer);
+
+FTargetInfoNetSerializer::FNetSerializerRegistryDelegates::~FNetSerializerRegistryDelegates()
+{
+	UE_NET_UNREGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_TargetInfo);
+}
+
+void FTargetInfoNetSerializer::FNetSerializerRegistryDelegates::OnPreFreezeNetSerializerRegistry()
+{
+	//Replaces the fallback to FTargetInfo::NetSerialize() for FTargetInfo properties.
+	UE_NET_REGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_TargetInfo);
+}
+
+}
+
+#endif
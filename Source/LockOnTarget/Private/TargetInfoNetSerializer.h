@@ -0,0 +1,28 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Iris/Serialization/NetSerializer.h"
+#include "TargetInfoNetSerializer.generated.h"
+
+/**
+ * Config of the Iris serializer of FTargetInfo. Has no settings.
+ * Declared regardless of UE_WITH_IRIS, as reflected types can't be conditionally compiled.
+ */
+USTRUCT()
+struct FTargetInfoNetSerializerConfig : public FNetSerializerConfig
+{
+	GENERATED_BODY()
+};
+
+#if UE_WITH_IRIS
+namespace UE::Net
+{
+	/**
+	 * Iris counterpart of FTargetInfo::NetSerialize().
+	 * The owner of the Target is replicated as a net object reference, the Socket as its index in the minimum bit width.
+	 */
+	UE_NET_DECLARE_SERIALIZER(FTargetInfoNetSerializer, );
+}
+#endif
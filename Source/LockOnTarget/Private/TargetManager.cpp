@@ -1,11 +1,195 @@
 // Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
 
 #include "TargetManager.h"
+#include "TargetComponent.h"
+#include "LockOnTargetComponent.h"
+#include "LockOnTargetDefines.h"
+
+#include "Algo/Transform.h"
 #include "Engine/World.h"
+#include "Components/ActorComponent.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarTargetStateCheckBudget(
+	TEXT("LockOnTarget.TargetStateCheckBudget"),
+	200.f,
+	TEXT("Per-frame budget in microseconds for scheduled CheckTargetState() calls. At least one instigator is checked each frame."),
+	ECVF_Default);
+
+/********************************************************************
+ * FRegisteredTargetsData
+ ********************************************************************/
+
+int32 FRegisteredTargetsData::Add(UTargetComponent* Target)
+{
+	const int32 Index = Targets.Add(Target);
+	Owners.AddZeroed();
+	Locations.AddZeroed();
+	CaptureRadii.AddZeroed();
+	Priorities.AddZeroed();
+	CanBeCaptured.Add(false);
+	LastRenderTimes.AddZeroed();
+	SocketsNum.AddZeroed();
+	Refresh(Index);
+	return Index;
+}
+
+void FRegisteredTargetsData::RemoveAtSwap(int32 Index)
+{
+	Targets.RemoveAtSwap(Index, 1, false);
+	Owners.RemoveAtSwap(Index, 1, false);
+	Locations.RemoveAtSwap(Index, 1, false);
+	CaptureRadii.RemoveAtSwap(Index, 1, false);
+	Priorities.RemoveAtSwap(Index, 1, false);
+	CanBeCaptured.RemoveAtSwap(Index);
+	LastRenderTimes.RemoveAtSwap(Index, 1, false);
+	SocketsNum.RemoveAtSwap(Index, 1, false);
+}
+
+void FRegisteredTargetsData::Refresh(int32 Index)
+{
+	const UTargetComponent* const Target = Targets[Index];
+	const AActor* const Owner = Target->GetOwner();
+
+	Owners[Index] = Owner;
+	Locations[Index] = Owner ? Owner->GetActorLocation() : FVector::ZeroVector;
+	CaptureRadii[Index] = Target->bForceCustomCaptureRadius ? Target->CustomCaptureRadius : -1.f;
+	Priorities[Index] = Target->Priority;
+	CanBeCaptured[Index] = Target->CanBeCaptured();
+	LastRenderTimes[Index] = Owner ? Owner->GetLastRenderTime() : -1000.f;
+	SocketsNum[Index] = Target->GetSockets().Num();
+}
+
+void FRegisteredTargetsData::Reset()
+{
+	Targets.Reset();
+	Owners.Reset();
+	Locations.Reset();
+	CaptureRadii.Reset();
+	Priorities.Reset();
+	CanBeCaptured.Reset();
+	LastRenderTimes.Reset();
+	SocketsNum.Reset();
+}
+
+FVector FRegisteredTargetsData::GetSocketLocation(int32 Index, int32 SocketIndex) const
+{
+	//The Target owns the only cache, as it knows when its Sockets move.
+	const UTargetComponent* const Target = Targets[Index];
+	return Target->GetSocketLocation(Target->GetSockets()[SocketIndex]);
+}
+
+/********************************************************************
+ * FTargetSpatialGrid
+ ********************************************************************/
+
+FTargetSpatialGrid::FTargetSpatialGrid(float InCellSize)
+	: CellSize(FMath::Max(InCellSize, 1.f))
+	, InvCellSize(1.f / CellSize)
+{
+}
+
+FIntPoint FTargetSpatialGrid::GetCellCoords(const FVector& Location) const
+{
+	return { FMath::FloorToInt32(Location.X * InvCellSize), FMath::FloorToInt32(Location.Y * InvCellSize) };
+}
+
+FIntPoint FTargetSpatialGrid::Add(int32 Index, const FVector& Location)
+{
+	const FIntPoint Coords = GetCellCoords(Location);
+	Cells.FindOrAdd(Coords).Add(Index);
+	return Coords;
+}
+
+void FTargetSpatialGrid::Remove(int32 Index, const FIntPoint& Coords)
+{
+	TArray<int32>& Cell = Cells.FindChecked(Coords);
+	Cell.RemoveSingleSwap(Index, false);
+
+	if (Cell.IsEmpty())
+	{
+		Cells.Remove(Coords);
+	}
+}
+
+void FTargetSpatialGrid::Update(int32 Index, const FVector& Location, FIntPoint& InOutCoords)
+{
+	const FIntPoint NewCoords = GetCellCoords(Location);
+
+	if (InOutCoords != NewCoords)
+	{
+		Remove(Index, InOutCoords);
+		Cells.FindOrAdd(NewCoords).Add(Index);
+		InOutCoords = NewCoords;
+	}
+}
+
+void FTargetSpatialGrid::Rename(int32 OldIndex, int32 NewIndex, const FIntPoint& Coords)
+{
+	int32* const Renamed = Cells.FindChecked(Coords).FindByKey(OldIndex);
+	check(Renamed);
+	*Renamed = NewIndex;
+}
+
+void FTargetSpatialGrid::Reset()
+{
+	Cells.Reset();
+}
+
+void FTargetSpatialGrid::QuerySphere(const FVector& Origin, float Radius, TConstArrayView<FVector> Locations, TArray<int32>& OutIndices) const
+{
+	const float RadiusSq = FMath::Square(Radius);
+
+	auto GatherCell = [&OutIndices, &Origin, &Locations, RadiusSq](const TArray<int32>& Cell)
+		{
+			for (const int32 Index : Cell)
+			{
+				if ((Locations[Index] - Origin).SizeSquared() <= RadiusSq)
+				{
+					OutIndices.Add(Index);
+				}
+			}
+		};
+
+	const FIntPoint Min = GetCellCoords(Origin - FVector(Radius));
+	const FIntPoint Max = GetCellCoords(Origin + FVector(Radius));
+	const int64 CoveredCellsNum = int64(Max.X - Min.X + 1) * int64(Max.Y - Min.Y + 1);
+
+	//It's cheaper to walk the non-empty cells if the sphere covers more cells than exist.
+	if (CoveredCellsNum > Cells.Num())
+	{
+		for (const auto& [Coords, Cell] : Cells)
+		{
+			if (Coords.X >= Min.X && Coords.X <= Max.X && Coords.Y >= Min.Y && Coords.Y <= Max.Y)
+			{
+				GatherCell(Cell);
+			}
+		}
+	}
+	else
+	{
+		for (int32 X = Min.X; X <= Max.X; ++X)
+		{
+			for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+			{
+				if (const TArray<int32>* const Cell = Cells.Find({ X, Y }))
+				{
+					GatherCell(*Cell);
+				}
+			}
+		}
+	}
+}
+
+/********************************************************************
+ * UTargetManager
+ ********************************************************************/
 
 UTargetManager::UTargetManager()
+	: NextTargetStateCheck(0)
 {
-	//Do something.
+	CaptureRadiusBuckets.Emplace(-1.f, SpatialGridCellSize);
 }
 
 UTargetManager& UTargetManager::Get(UWorld& InWorld)
@@ -25,6 +209,31 @@ bool UTargetManager::DoesSupportWorldType(const EWorldType::Type Type) const
 	return Type == EWorldType::Game || Type == EWorldType::PIE;
 }
 
+TStatId UTargetManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTargetManager, STATGROUP_LockOnTarget);
+}
+
+void UTargetManager::Tick(float DeltaTime)
+{
+	LOT_SCOPED_EVENT(TargetManager_Tick);
+
+	Super::Tick(DeltaTime);
+
+	for (int32 i = 0; i < TargetsData.Num(); ++i)
+	{
+		TargetsData.Refresh(i);
+		UpdateCaptureRadiusBucket(i);
+	}
+
+	ProcessScheduledTargetStateChecks();
+
+	//The frame totals of the added counters are recorded by now.
+	LOT_COUNTER_RESET(SecondarySamplingCandidatesTested);
+	LOT_COUNTER_RESET(LineOfSightTraces);
+	LOT_COUNTER_RESET(DetailedResponses);
+}
+
 bool UTargetManager::RegisterTarget(UTargetComponent* Target)
 {
 	bool bHasAlreadyBeen = true;
@@ -32,6 +241,19 @@ bool UTargetManager::RegisterTarget(UTargetComponent* Target)
 	if (Target)
 	{
 		RegisteredTargets.Add(Target, &bHasAlreadyBeen);
+
+		if (!bHasAlreadyBeen)
+		{
+			const int32 Index = TargetsData.Add(Target);
+			TargetIndices.Add(Target, Index);
+			OwnerTargets.FindOrAdd(Target->GetOwner(), Target);
+			TargetBuckets.Add(INDEX_NONE);
+			TargetCells.AddDefaulted();
+			AddToCaptureRadiusBucket(Index);
+
+			INC_DWORD_STAT(STAT_LOT_RegisteredTargets);
+			TRACE_COUNTER_INCREMENT(LOT_RegisteredTargets);
+		}
 	}
 
 	return !bHasAlreadyBeen;
@@ -39,5 +261,250 @@ bool UTargetManager::RegisterTarget(UTargetComponent* Target)
 
 bool UTargetManager::UnregisterTarget(UTargetComponent* Target)
 {
+	int32 Index = INDEX_NONE;
+
+	if (TargetIndices.RemoveAndCopyValue(Target, Index))
+	{
+		const int32 LastIndex = TargetsData.Num() - 1;
+
+		const AActor* const Owner = TargetsData.Owners[Index];
+
+		if (OwnerTargets.FindRef(Owner) == Target)
+		{
+			OwnerTargets.Remove(Owner);
+
+			//The owner might have other registered Targets.
+			if (Owner)
+			{
+				for (UTargetComponent* const OtherTarget : TInlineComponentArray<UTargetComponent*>(Owner))
+				{
+					if (OtherTarget != Target && TargetIndices.Contains(OtherTarget))
+					{
+						OwnerTargets.Add(Owner, OtherTarget);
+						break;
+					}
+				}
+			}
+		}
+
+		RemoveFromCaptureRadiusBucket(Index);
+
+		if (Index != LastIndex)
+		{
+			TargetIndices[TargetsData.Targets[LastIndex]] = Index;
+			CaptureRadiusBuckets[TargetBuckets[LastIndex]].Grid.Rename(LastIndex, Index, TargetCells[LastIndex]);
+		}
+
+		TargetsData.RemoveAtSwap(Index);
+		TargetBuckets.RemoveAtSwap(Index, 1, false);
+		TargetCells.RemoveAtSwap(Index, 1, false);
+
+		DEC_DWORD_STAT(STAT_LOT_RegisteredTargets);
+		TRACE_COUNTER_DECREMENT(LOT_RegisteredTargets);
+	}
+
 	return RegisteredTargets.Remove(Target) > 0;
 }
+
+void UTargetManager::RefreshTarget(UTargetComponent* Target)
+{
+	if (const int32* const Index = TargetIndices.Find(Target))
+	{
+		TargetsData.Refresh(*Index);
+		UpdateCaptureRadiusBucket(*Index);
+	}
+}
+
+UTargetComponent* UTargetManager::FindTargetComponent(const AActor* Owner)
+{
+	UTargetComponent* Target = nullptr;
+
+	if (Owner)
+	{
+		if (const UWorld* const World = Owner->GetWorld())
+		{
+			if (const UTargetManager* const TargetManager = World->GetSubsystem<UTargetManager>())
+			{
+				Target = TargetManager->FindTargetByOwner(Owner);
+			}
+		}
+
+		if (!Target)
+		{
+			Target = Owner->FindComponentByClass<UTargetComponent>();
+		}
+	}
+
+	return Target;
+}
+
+int32 UTargetManager::FindOrAddCaptureRadiusBucket(float CaptureRadius)
+{
+	if (CaptureRadius < 0.f)
+	{
+		return DefaultCaptureRadiusBucket;
+	}
+
+	const int32 BucketIndex = CaptureRadiusBuckets.IndexOfByPredicate([CaptureRadius](const FTargetCaptureRadiusBucket& Bucket)
+		{
+			return Bucket.CaptureRadius == CaptureRadius;
+		});
+
+	//The cell matches the radius, so a query only touches a few cells.
+	return BucketIndex != INDEX_NONE ? BucketIndex : CaptureRadiusBuckets.Emplace(CaptureRadius, FMath::Max(CaptureRadius, MinSpatialGridCellSize));
+}
+
+void UTargetManager::AddToCaptureRadiusBucket(int32 Index)
+{
+	const int32 BucketIndex = FindOrAddCaptureRadiusBucket(TargetsData.CaptureRadii[Index]);
+	FTargetCaptureRadiusBucket& Bucket = CaptureRadiusBuckets[BucketIndex];
+	TargetBuckets[Index] = BucketIndex;
+	TargetCells[Index] = Bucket.Grid.Add(Index, TargetsData.Locations[Index]);
+	++Bucket.TargetsNum;
+}
+
+void UTargetManager::RemoveFromCaptureRadiusBucket(int32 Index)
+{
+	const int32 BucketIndex = TargetBuckets[Index];
+	FTargetCaptureRadiusBucket& Bucket = CaptureRadiusBuckets[BucketIndex];
+	Bucket.Grid.Remove(Index, TargetCells[Index]);
+	--Bucket.TargetsNum;
+	TargetBuckets[Index] = INDEX_NONE;
+
+	//Custom radii are rarely changed at runtime, so empty buckets are removed right away.
+	if (Bucket.TargetsNum == 0 && BucketIndex != DefaultCaptureRadiusBucket)
+	{
+		const int32 LastBucketIndex = CaptureRadiusBuckets.Num() - 1;
+		CaptureRadiusBuckets.RemoveAtSwap(BucketIndex, 1, false);
+
+		if (BucketIndex != LastBucketIndex)
+		{
+			for (int32& TargetBucket : TargetBuckets)
+			{
+				if (TargetBucket == LastBucketIndex)
+				{
+					TargetBucket = BucketIndex;
+				}
+			}
+		}
+	}
+}
+
+void UTargetManager::UpdateCaptureRadiusBucket(int32 Index)
+{
+	FTargetCaptureRadiusBucket& Bucket = CaptureRadiusBuckets[TargetBuckets[Index]];
+	const float CaptureRadius = TargetsData.CaptureRadii[Index];
+
+	if (Bucket.CaptureRadius == CaptureRadius || (Bucket.CaptureRadius < 0.f && CaptureRadius < 0.f))
+	{
+		Bucket.Grid.Update(Index, TargetsData.Locations[Index], TargetCells[Index]);
+	}
+	else
+	{
+		RemoveFromCaptureRadiusBucket(Index);
+		AddToCaptureRadiusBucket(Index);
+	}
+}
+
+void UTargetManager::ScheduleTargetStateCheck(ULockOnTargetComponent* Instigator)
+{
+	const bool bIsScheduled = ScheduledTargetStateChecks.ContainsByPredicate([Instigator](const FScheduledTargetStateCheck& Check)
+		{
+			return Check.Instigator == Instigator;
+		});
+
+	if (Instigator && !bIsScheduled)
+	{
+		ScheduledTargetStateChecks.Add({ Instigator, GetWorld()->GetTimeSeconds() });
+	}
+}
+
+void UTargetManager::UnscheduleTargetStateCheck(ULockOnTargetComponent* Instigator)
+{
+	//Only invalidated, as it might be called while processing.
+	for (FScheduledTargetStateCheck& Check : ScheduledTargetStateChecks)
+	{
+		if (Check.Instigator == Instigator)
+		{
+			Check.Instigator.Reset();
+		}
+	}
+}
+
+void UTargetManager::ProcessScheduledTargetStateChecks()
+{
+	ScheduledTargetStateChecks.RemoveAll([](const FScheduledTargetStateCheck& Check)
+		{
+			return !Check.Instigator.IsValid();
+		});
+
+	const int32 ChecksNum = ScheduledTargetStateChecks.Num();
+
+	if (ChecksNum == 0)
+	{
+		NextTargetStateCheck = 0;
+		return;
+	}
+
+	LOT_SCOPED_EVENT(TargetManager_ScheduledTargetStateChecks);
+
+	const double WorldTime = GetWorld()->GetTimeSeconds();
+	const double BudgetSeconds = FMath::Max(CVarTargetStateCheckBudget.GetValueOnGameThread(), 0.f) * 1e-6;
+	const double StartTime = FPlatformTime::Seconds();
+
+	for (int32 i = 0; i < ChecksNum; ++i)
+	{
+		NextTargetStateCheck %= ChecksNum;
+
+		//Copied, as the array might be changed by the check.
+		const FScheduledTargetStateCheck Check = ScheduledTargetStateChecks[NextTargetStateCheck];
+		ScheduledTargetStateChecks[NextTargetStateCheck].LastCheckTime = WorldTime;
+		++NextTargetStateCheck;
+
+		ULockOnTargetComponent* const Instigator = Check.Instigator.Get();
+
+		if (Instigator && Instigator->IsTargetLocked() && Instigator->HasAuthorityOverTarget())
+		{
+			Instigator->CheckTargetState(static_cast<float>(WorldTime - Check.LastCheckTime));
+		}
+
+		if (FPlatformTime::Seconds() - StartTime > BudgetSeconds)
+		{
+			break;
+		}
+	}
+}
+
+void UTargetManager::QueryTargetIndicesInSphere(const FVector& ViewLocation, float Radius, TArray<int32>& OutIndices) const
+{
+	LOT_SCOPED_EVENT(TargetManager_QuerySphere);
+
+	for (const FTargetCaptureRadiusBucket& Bucket : CaptureRadiusBuckets)
+	{
+		if (Bucket.TargetsNum > 0)
+		{
+			Bucket.Grid.QuerySphere(ViewLocation, Radius, TargetsData.Locations, OutIndices);
+		}
+	}
+}
+
+void UTargetManager::QueryTargetIndicesInCaptureRadius(const FVector& ViewLocation, float DefaultRadius, float RadiusScale, TArray<int32>& OutIndices) const
+{
+	LOT_SCOPED_EVENT(TargetManager_QueryCaptureRadius);
+
+	for (const FTargetCaptureRadiusBucket& Bucket : CaptureRadiusBuckets)
+	{
+		if (Bucket.TargetsNum > 0)
+		{
+			const float Radius = RadiusScale * (Bucket.CaptureRadius < 0.f ? DefaultRadius : Bucket.CaptureRadius);
+			Bucket.Grid.QuerySphere(ViewLocation, Radius, TargetsData.Locations, OutIndices);
+		}
+	}
+}
+
+void UTargetManager::QueryTargetsInSphere(const FVector& ViewLocation, float Radius, TArray<UTargetComponent*>& OutTargets) const
+{
+	TArray<int32> Indices;
+	QueryTargetIndicesInSphere(ViewLocation, Radius, Indices);
+	Algo::Transform(Indices, OutTargets, [this](int32 Index) { return TargetsData.Targets[Index]; });
+}
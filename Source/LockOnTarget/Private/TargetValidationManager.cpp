@@ -0,0 +1,239 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#include "TargetValidationManager.h"
+#include "LockOnTargetComponent.h"
+#include "TargetComponent.h"
+#include "TargetHandlers/WeightedTargetHandler.h"
+#include "LockOnTargetDefines.h"
+
+#include "CollisionQueryParams.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Controller.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarClaimValidationMaxDistance(
+	TEXT("LockOnTarget.ClaimValidation.MaxDistance"),
+	0.f,
+	TEXT("Max distance between the instigator and the Target owners claimed by remote instigators. 0 disables the check."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarClaimValidationLineOfSight(
+	TEXT("LockOnTarget.ClaimValidation.LineOfSight"),
+	false,
+	TEXT("Whether the Target claimed by remote instigators should be visible from the instigator owner eyes."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarClaimValidationCacheLifetime(
+	TEXT("LockOnTarget.ClaimValidation.CacheLifetime"),
+	0.5f,
+	TEXT("Seconds the visibility of an instigator-Target pair is trusted before it's traced again."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarClaimValidationLostDelay(
+	TEXT("LockOnTarget.ClaimValidation.LostDelay"),
+	3.f,
+	TEXT("Seconds the held Target may stay occluded before the claim is revoked, unless the instigator uses UWeightedTargetHandler with its own LostTargetDelay."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarClaimValidationTraceChannel(
+	TEXT("LockOnTarget.ClaimValidation.TraceChannel"),
+	ECC_Visibility,
+	TEXT("The collision channel of visibility traces."),
+	ECVF_Default);
+
+bool UTargetValidationManager::IsClaimValidationEnabled()
+{
+	return CVarClaimValidationMaxDistance.GetValueOnGameThread() > 0.f || CVarClaimValidationLineOfSight.GetValueOnGameThread();
+}
+
+bool UTargetValidationManager::ValidateTargetClaim(ULockOnTargetComponent* Instigator, const FTargetInfo& Target)
+{
+	LOT_SCOPED_EVENT(ValidateTargetClaim);
+
+	const AActor* const InstigatorOwner = Instigator ? Instigator->GetOwner() : nullptr;
+	const AActor* const TargetOwner = IsValid(Target.TargetComponent) ? Target->GetOwner() : nullptr;
+
+	if (!InstigatorOwner || !TargetOwner)
+	{
+		return false;
+	}
+
+	const float MaxDistance = CVarClaimValidationMaxDistance.GetValueOnGameThread();
+
+	if (MaxDistance > 0.f && FVector::DistSquared(InstigatorOwner->GetActorLocation(), TargetOwner->GetActorLocation()) > FMath::Square(MaxDistance))
+	{
+		return false;
+	}
+
+	if (!CVarClaimValidationLineOfSight.GetValueOnGameThread())
+	{
+		return true;
+	}
+
+	const double Time = GetWorld()->GetTimeSeconds();
+	const FClaimKey Key(Instigator, Target.TargetComponent);
+	FClaimVisibility& Visibility = ClaimVisibilities.FindOrAdd(Key);
+
+	//Raw keys may be reused by new objects after the old ones are collected.
+	if (Visibility.Instigator != Instigator || Visibility.Target != Target.TargetComponent)
+	{
+		Visibility = FClaimVisibility();
+		Visibility.Instigator = Instigator;
+		Visibility.Target = Target.TargetComponent;
+	}
+
+	Visibility.Socket = Target.Socket;
+	Visibility.ClaimTime = Time;
+
+	if (!Visibility.bTracePending && (Visibility.UpdateTime < 0.0 || Time - Visibility.UpdateTime > CVarClaimValidationCacheLifetime.GetValueOnGameThread()))
+	{
+		RequestVisibilityTrace(Key, Visibility);
+	}
+
+	//Unknown pairs get the benefit of the doubt until the trace completes. Held pairs are revoked only after the grace period, see Tick().
+	return !Visibility.IsOccluded();
+}
+
+void UTargetValidationManager::RequestVisibilityTrace(const FClaimKey& Key, FClaimVisibility& Visibility)
+{
+	const AActor* const InstigatorOwner = Visibility.Instigator->GetOwner();
+	const AActor* const TargetOwner = Visibility.Target->GetOwner();
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	GetInstigatorViewPoint(InstigatorOwner, ViewLocation, ViewRotation);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT_NAME_ONLY(LockOnTargetClaimValidation));
+	QueryParams.AddIgnoredActor(InstigatorOwner);
+	QueryParams.AddIgnoredActor(TargetOwner);
+
+	FTraceDelegate TraceDelegate = FTraceDelegate::CreateUObject(this, &ThisClass::OnVisibilityTraceCompleted, Key);
+	const ECollisionChannel TraceChannel = static_cast<ECollisionChannel>(CVarClaimValidationTraceChannel.GetValueOnGameThread());
+
+	LOT_COUNTER_ADD(LineOfSightTraces, 1);
+	GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, ViewLocation, Visibility.Target->GetSocketLocation(Visibility.Socket), TraceChannel, QueryParams, FCollisionResponseParams::DefaultResponseParam, &TraceDelegate);
+	Visibility.bTracePending = true;
+}
+
+void UTargetValidationManager::OnVisibilityTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum, FClaimKey Key)
+{
+	FClaimVisibility* const Visibility = ClaimVisibilities.Find(Key);
+
+	if (!Visibility || !Visibility->Instigator.IsValid() || !Visibility->Target.IsValid())
+	{
+		return;
+	}
+
+	const double Time = GetWorld()->GetTimeSeconds();
+	const bool bVisible = !Datum.OutHits.ContainsByPredicate([](const FHitResult& HitResult)
+		{
+			return HitResult.bBlockingHit;
+		});
+
+	Visibility->bTracePending = false;
+	Visibility->UpdateTime = Time;
+
+	if (bVisible)
+	{
+		Visibility->OccludedTime = -1.0;
+	}
+	else if (!Visibility->IsOccluded())
+	{
+		Visibility->OccludedTime = Time;
+	}
+}
+
+void UTargetValidationManager::GetInstigatorViewPoint(const AActor* InstigatorOwner, FVector& OutLocation, FRotator& OutRotation)
+{
+	//Mirrors UWeightedTargetHandler::GetPointOfView(), as the client finds Targets from the camera, which the server knows from camera updates.
+	InstigatorOwner->GetActorEyesViewPoint(OutLocation, OutRotation);
+
+	if (const AController* const Controller = InstigatorOwner->GetInstigatorController())
+	{
+		Controller->GetPlayerViewPoint(OutLocation, OutRotation);
+	}
+}
+
+float UTargetValidationManager::GetLostDelay(const ULockOnTargetComponent* Instigator)
+{
+	const UWeightedTargetHandler* const Handler = Cast<UWeightedTargetHandler>(Instigator->GetTargetHandler());
+	return Handler && Handler->bLineOfSightCheck ? Handler->LostTargetDelay : CVarClaimValidationLostDelay.GetValueOnGameThread();
+}
+
+bool UTargetValidationManager::DoesSupportWorldType(const EWorldType::Type Type) const
+{
+	return Type == EWorldType::Game || Type == EWorldType::PIE;
+}
+
+TStatId UTargetValidationManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTargetValidationManager, STATGROUP_LockOnTarget);
+}
+
+void UTargetValidationManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (ClaimVisibilities.IsEmpty())
+	{
+		return;
+	}
+
+	if (!CVarClaimValidationLineOfSight.GetValueOnGameThread())
+	{
+		ClaimVisibilities.Reset();
+		return;
+	}
+
+	const double Time = GetWorld()->GetTimeSeconds();
+	const float CacheLifetime = CVarClaimValidationCacheLifetime.GetValueOnGameThread();
+
+	//Pairs that aren't claimed anymore are kept for a couple of lifetimes to absorb fast switching back and forth.
+	const double EvictionTime = 2.0 * FMath::Max(CacheLifetime, 0.1f);
+
+	//Revocation modifies the cache through the instigator, so it's deferred until the iteration is finished.
+	TArray<ULockOnTargetComponent*, TInlineAllocator<4>> RevokedInstigators;
+
+	for (auto It = ClaimVisibilities.CreateIterator(); It; ++It)
+	{
+		FClaimVisibility& Visibility = It->Value;
+
+		if (!Visibility.Instigator.IsValid() || !Visibility.Target.IsValid())
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		ULockOnTargetComponent* const Instigator = Visibility.Instigator.Get();
+
+		if (Instigator->GetTargetComponent() == Visibility.Target.Get())
+		{
+			//Held claims are kept and traced on their own, not only when claimed again.
+			Visibility.ClaimTime = Time;
+
+			if (Visibility.IsOccluded() && Time - Visibility.OccludedTime > GetLostDelay(Instigator))
+			{
+				LOG_WARNING("%s holds the Target %s that has been invisible for too long.", *GetNameSafe(Instigator->GetOwner()), *GetNameSafe(Visibility.Target->GetOwner()));
+				RevokedInstigators.Add(Instigator);
+				It.RemoveCurrent();
+				continue;
+			}
+
+			if (!Visibility.bTracePending && Time - Visibility.UpdateTime > CacheLifetime)
+			{
+				Visibility.Socket = Instigator->GetCapturedSocket();
+				RequestVisibilityTrace(It->Key, Visibility);
+			}
+		}
+		else if (!Visibility.bTracePending && Time - Visibility.ClaimTime > EvictionTime)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	for (ULockOnTargetComponent* const Instigator : RevokedInstigators)
+	{
+		Instigator->RevokeTargetClaim();
+	}
+}
@@ -5,6 +5,7 @@
 #include "Components/ActorComponent.h"
 #include "CoreMinimal.h"
 #include "LockOnTargetTypes.h"
+#include "TargetHandlers/TargetHandlerBase.h"
 #include "LockOnTargetComponent.generated.h"
 
 class ULockOnTargetComponent;
@@ -13,6 +14,9 @@ class AActor;
 class UTargetHandlerBase;
 class ULockOnTargetExtensionBase;
 class ULockOnTargetExtensionProxy;
+class AGameModeBase;
+class AController;
+class APlayerController;
 
 struct FFindTargetRequestParams;
 struct FFindTargetRequestResponse;
@@ -40,6 +44,8 @@ public:
 
 	ULockOnTargetComponent();
 	friend class FGameplayDebuggerCategory_LockOnTarget; //Gameplay Debugger
+	friend class UTargetManager; //Scheduled CheckTargetState()
+	friend class UTargetValidationManager; //RevokeTargetClaim()
 	
 private: /** Core Config */
 
@@ -55,6 +61,48 @@ private: /** Core Config */
 	UPROPERTY(Instanced, EditDefaultsOnly, Category = "Extensions", meta = (DisplayName = "Default Extensions", NoResetToDefault))
 	TArray<TObjectPtr<ULockOnTargetExtensionBase>> Extensions;
 
+	/**
+	 * Checks the Target state via the TargetManager instead of each tick. The TargetManager time-slices checks of all scheduled instigators.
+	 * Keeps the frame cost flat with many instigators, e.g. AI. The budget is set by LockOnTarget.TargetStateCheckBudget.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Default Settings")
+	bool bScheduledTargetStateCheck;
+
+public: /** Network Config */
+
+	/**
+	 * Sends switches within the same lock via an unreliable sequenced RPC. Captures and releases are always sent reliably.
+	 * Prevents fast switching from saturating the reliable buffer. The server drops switches older than the last received update.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Network")
+	bool bUnreliableTargetSwitch;
+
+	/** The last switch of a series is confirmed reliably after this delay without switches, as unreliable ones may be lost. */
+	UPROPERTY(EditDefaultsOnly, Category = "Network", meta = (ClampMin = 0.f, Units = "s", EditCondition = "bUnreliableTargetSwitch", EditConditionHides))
+	float TargetSwitchConfirmationDelay;
+
+	/**
+	 * Replicates the component only to connections whose view target is within the distance of the owner or the captured Target. 0 replicates to all.
+	 * Distant simulated proxies keep the last received Target until they come closer.
+	 * Requires the owner to replicate using the registered subobject list. @see AActor::bReplicateUsingRegisteredSubObjectList.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Network", meta = (ClampMin = 0.f, Units = "cm"))
+	float TargetReplicationDistance;
+
+	/**
+	 * How often the server re-evaluates distances of connections the component is replicated to. Target changes are picked up by the next evaluation.
+	 * Joining players don't wait for it. The owning connection and replays always receive the component.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Network", meta = (ClampMin = 0.1f, Units = "s", EditCondition = "TargetReplicationDistance > 0", EditConditionHides))
+	float TargetReplicationUpdateInterval;
+
+	/**
+	 * Records lock, unlock and Socket change events into a stream replicated only into replays. GetReplayStream().
+	 * Recorded on the server, and on clients while they record their own replay, e.g. a kill-cam. Timed by the demo clock.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Network")
+	bool bRecordReplayEvents;
+
 public: /** Input Config */
 
 	/** When the InputBuffer overflows the threshold by the input, the switch method will be called. */
@@ -109,9 +157,31 @@ private: /** Internal */
 	UPROPERTY(Transient, Replicated)
 	float TargetingDuration;
 
+	//Recent lock-on events. Replicated only into replays.
+	UPROPERTY(Transient, Replicated)
+	FLockOnTargetReplayStream ReplayStream;
+
 	//Is any Target captured.
 	bool bIsTargetLocked;
 
+	//The sequence of the last Target update. Sent by the owning client and received by the server.
+	//Serves as the prediction key of the update, which the server acknowledges or rejects.
+	uint8 TargetUpdateSequence;
+
+	//Pending reliable confirmation of the last unreliable switch.
+	FTimerHandle TargetSwitchConfirmationHandle;
+
+	//The net condition group of nearby connections the component is replicated to, besides the owner and replay groups. None if replicated to all.
+	FName TargetReplicationGroup;
+	FTimerHandle TargetReplicationUpdateHandle;
+	FDelegateHandle PostLoginHandle;
+	FDelegateHandle LogoutHandle;
+
+	//The TargetHandler request in progress.
+	FFindTargetRequestHandle PendingFindTargetRequest;
+
+	void OnFindTargetRequestCompleted(FFindTargetRequestHandle Handle, const FFindTargetRequestResponse& Response);
+
 protected: /** Input Internal */
 
 	bool bInputFrozen;
@@ -142,6 +212,9 @@ public: /** Polls */
 	UFUNCTION(BlueprintPure, Category = "LockOnTargetComponent|Polls")
 	float GetTargetingDuration() const { return TargetingDuration; }
 
+	/** Returns recent lock-on events. Filled on the server, in client-recorded replays and in their playback if bRecordReplayEvents is set. */
+	const FLockOnTargetReplayStream& GetReplayStream() const { return ReplayStream; }
+
 	/** Returns the World location of the captured Socket. */
 	UFUNCTION(BlueprintPure, Category = "LockOnTargetComponent|Polls")
 	FVector GetCapturedSocketLocation() const;
@@ -190,13 +263,17 @@ public: /** Class Main Interface */
 
 protected: /** Target Handling */
 
-	//Performs to find a Target. Default implementation uses the TargetHandler.
+	//Performs to find a Target. Default implementation requests it from the TargetHandler, which may respond in later frames.
+	//A new request cancels the previous one.
 	//@Warning - Potential reliable server call. Use carefully without wrapper.
 	virtual void RequestFindTarget(const FFindTargetRequestParams& RequestParams);
 
 	//Processes the Target returned by the TargetHandler.
 	virtual void ProcessTargetHandlerResponse(const FFindTargetRequestResponse& Response);
 
+	//Cancels the FindTarget request in progress, if exists.
+	void CancelPendingFindTargetRequest();
+
 	//Checks the Target state. Usually between updates.
 	virtual void CheckTargetState(float DeltaTime);
 
@@ -216,11 +293,57 @@ protected: /** Target Synchronization */
 	//Updates the CurrentTargetInternal locally and sends it to the server.
 	void UpdateTargetInfo(const FTargetInfo& TargetInfo);
 
-	//Updates the Target on the server.
-	UFUNCTION(Server, Reliable, WithValidation)
-	void Server_UpdateTargetInfo(const FTargetInfo& TargetInfo);
-	void Server_UpdateTargetInfo_Implementation(const FTargetInfo& TargetInfo);
-	bool Server_UpdateTargetInfo_Validate(const FTargetInfo& TargetInfo);
+	//Updates the CurrentTargetInternal locally.
+	void ApplyTargetInfo(const FTargetInfo& TargetInfo);
+
+	//Appends the change of the CurrentTargetInternal to the ReplayStream.
+	bool ShouldRecordReplayEvents() const;
+	void RecordReplayEvent(const FTargetInfo& OldTarget);
+
+	//Updates the Target on the server. Used to capture and release the Target, and to confirm switches.
+	UFUNCTION(Server, Reliable)
+	void Server_UpdateTargetInfo(const FTargetInfo& TargetInfo, uint8 Sequence);
+	void Server_UpdateTargetInfo_Implementation(const FTargetInfo& TargetInfo, uint8 Sequence);
+
+	//Switches the captured Target on the server. Can't capture or release the Target.
+	UFUNCTION(Server, Unreliable)
+	void Server_SwitchTargetInfo(const FTargetInfo& TargetInfo, uint8 Sequence);
+	void Server_SwitchTargetInfo_Implementation(const FTargetInfo& TargetInfo, uint8 Sequence);
+
+	//Sends the current Target reliably after a series of unreliable switches.
+	void ConfirmTargetSwitch();
+
+	//Checks the Target claimed by the owning client via the UTargetValidationManager.
+	bool IsTargetClaimValid(const FTargetInfo& TargetInfo);
+
+	//Releases the Target on the server and the owning client, if the claim turned out to be invalid after it had been accepted.
+	void RevokeTargetClaim();
+
+	//Acknowledges the predicted update on the owning client.
+	UFUNCTION(Client, Unreliable)
+	void Client_AckTargetUpdate(uint8 Sequence);
+	void Client_AckTargetUpdate_Implementation(uint8 Sequence);
+
+	//Rejects the predicted update on the owning client and rolls it back to the server Target.
+	UFUNCTION(Client, Reliable)
+	void Client_RejectTargetUpdate(uint8 Sequence, const FTargetInfo& ServerTarget);
+	void Client_RejectTargetUpdate_Implementation(uint8 Sequence, const FTargetInfo& ServerTarget);
+
+	//Replicates the component only to members of TargetReplicationGroup on the server.
+	void StartTargetReplicationFiltering();
+	void StopTargetReplicationFiltering();
+
+	//Adds connections close to the owner or the captured Target to TargetReplicationGroup and removes the others. Runs at TargetReplicationUpdateInterval.
+	void UpdateTargetReplicationGroup();
+
+	//Adds the remote player connection of the PlayerController to TargetReplicationGroup or removes it.
+	void UpdateTargetReplicationMembership(APlayerController* PlayerController);
+
+	void OnPlayerPostLogin(AGameModeBase* GameMode, APlayerController* NewPlayer);
+	void OnPlayerLogout(AGameModeBase* GameMode, AController* Exiting);
+
+	//Sequences wrap around, so the newer one is within the half range ahead.
+	static bool IsTargetUpdateSequenceNewer(uint8 Sequence, uint8 LastSequence) { return static_cast<int8>(Sequence - LastSequence) > 0; }
 
 private: /** Target State Workhorse */
 
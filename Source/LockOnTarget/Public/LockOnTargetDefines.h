@@ -5,6 +5,8 @@
 #include "Logging/LogMacros.h"
 #include "Trace/Trace.h"
 #include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "Stats/Stats.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogLockOnTarget, All, All);
 
@@ -12,6 +14,40 @@ DECLARE_LOG_CATEGORY_EXTERN(LogLockOnTarget, All, All);
 #define LOG_WARNING(Str, ...) UE_LOG(LogLockOnTarget, Warning, TEXT("%s[%d]: " Str), *FString(__FUNCTION__), __LINE__, ##__VA_ARGS__)
 #define LOG_ERROR(Str, ...) UE_LOG(LogLockOnTarget, Error, TEXT("%s[%d]: " Str), *FString(__FUNCTION__), __LINE__, ##__VA_ARGS__)
 
+//Stats group. stat LockOnTarget
+DECLARE_STATS_GROUP(TEXT("LockOnTarget"), STATGROUP_LockOnTarget, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("FindTarget"), STAT_LOT_FindTarget, STATGROUP_LockOnTarget, LOCKONTARGET_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pass PrimarySampling"), STAT_LOT_PrimarySampling, STATGROUP_LockOnTarget, LOCKONTARGET_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pass Solver"), STAT_LOT_Solver, STATGROUP_LockOnTarget, LOCKONTARGET_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pass Sort"), STAT_LOT_Sort, STATGROUP_LockOnTarget, LOCKONTARGET_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pass SecondarySampling"), STAT_LOT_SecondarySampling, STATGROUP_LockOnTarget, LOCKONTARGET_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CheckTargetState"), STAT_LOT_CheckTargetState, STATGROUP_LockOnTarget, LOCKONTARGET_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("PrimarySampling Candidates In"), STAT_LOT_PrimarySamplingCandidatesIn, STATGROUP_LockOnTarget, LOCKONTARGET_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("PrimarySampling Candidates Out"), STAT_LOT_PrimarySamplingCandidatesOut, STATGROUP_LockOnTarget, LOCKONTARGET_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("SecondarySampling Candidates In"), STAT_LOT_SecondarySamplingCandidatesIn, STATGROUP_LockOnTarget, LOCKONTARGET_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("SecondarySampling Candidates Tested"), STAT_LOT_SecondarySamplingCandidatesTested, STATGROUP_LockOnTarget, LOCKONTARGET_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("LineOfSight Traces"), STAT_LOT_LineOfSightTraces, STATGROUP_LockOnTarget, LOCKONTARGET_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Detailed Responses"), STAT_LOT_DetailedResponses, STATGROUP_LockOnTarget, LOCKONTARGET_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Registered Targets"), STAT_LOT_RegisteredTargets, STATGROUP_LockOnTarget, LOCKONTARGET_API);
+
+//Unreal Insights counters. -trace=default,counters
+TRACE_DECLARE_INT_COUNTER_EXTERN(LOT_PrimarySamplingCandidatesIn);
+TRACE_DECLARE_INT_COUNTER_EXTERN(LOT_PrimarySamplingCandidatesOut);
+TRACE_DECLARE_INT_COUNTER_EXTERN(LOT_SecondarySamplingCandidatesIn);
+TRACE_DECLARE_INT_COUNTER_EXTERN(LOT_SecondarySamplingCandidatesTested);
+TRACE_DECLARE_INT_COUNTER_EXTERN(LOT_LineOfSightTraces);
+TRACE_DECLARE_INT_COUNTER_EXTERN(LOT_DetailedResponses);
+TRACE_DECLARE_INT_COUNTER_EXTERN(LOT_RegisteredTargets);
+
+//Sets both counters to the value, e.g. the size of the latest query.
+#define LOT_COUNTER_SET(CounterName, Value) do { SET_DWORD_STAT(STAT_LOT_##CounterName, Value); TRACE_COUNTER_SET(LOT_##CounterName, Value); } while (0)
+
+//Adds the value to both per frame counters. The trace counter is reset by LOT_COUNTER_RESET() once per frame, as opposed to the stat one reset by the stats system.
+#define LOT_COUNTER_ADD(CounterName, Value) do { INC_DWORD_STAT_BY(STAT_LOT_##CounterName, Value); TRACE_COUNTER_ADD(LOT_##CounterName, Value); } while (0)
+#define LOT_COUNTER_RESET(CounterName) TRACE_COUNTER_SET(LOT_##CounterName, 0)
+
 #if CPUPROFILERTRACE_ENABLED
 
 //Custom channel declaration. -trace=default,LockOnTarget
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Net/Serialization/FastArraySerializer.h"
 #include "LockOnTargetTypes.generated.h"
 
 class UTargetComponent;
@@ -42,10 +43,16 @@ public:
 
 	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
 
-private:
-
+	//Gets the index of the Socket in the Target Sockets. 0 if not found.
 	uint32 GetSocketIndex() const;
 
+	//The number of bits of the Socket index width code. The last code is reserved for indices that don't fit in the other widths.
+	static constexpr uint32 SocketIndexWidthCodeBits = 3;
+	static constexpr uint32 SocketIndexWidthCodePacked = (1 << SocketIndexWidthCodeBits) - 1;
+
+	//Gets the code of the minimum width of the Socket index. Indices are serialized in WidthCode + 1 bits, or as a packed int if it's cheaper.
+	static uint32 GetSocketIndexWidthCode(uint32 SocketIndex);
+
 public:
 
 	UPROPERTY(BlueprintReadWrite, Category = "TargetInfo")
@@ -75,6 +82,96 @@ inline bool operator!=(const FTargetInfo& lhs, const FTargetInfo& rhs)
 	return !(lhs == rhs);
 }
 
+/**
+ * The types of lock-on events recorded for replays.
+ */
+UENUM()
+enum class ELockOnTargetReplayEventType : uint8
+{
+	Lock,
+	Unlock,
+	SocketChange,
+
+	//The Target captured at the start of the recorded window, i.e. after the dropped events.
+	Base
+};
+
+/**
+ * A lock-on event recorded for replays.
+ */
+USTRUCT()
+struct LOCKONTARGET_API FLockOnTargetReplayEvent : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+public:
+
+	//Demo time of the event, i.e. seconds since the recording start. Matches UDemoNetDriver::GetDemoCurrentTime() during playback.
+	UPROPERTY()
+	double Time = 0.0;
+
+	UPROPERTY()
+	ELockOnTargetReplayEventType Type = ELockOnTargetReplayEventType::Lock;
+
+	//The Target after the event. Null if unlocked.
+	UPROPERTY()
+	FTargetInfo Target;
+};
+
+/**
+ * Recent lock-on events in chronological order. Replicated only into replays.
+ * Only new events are recorded as deltas, while checkpoints hold the whole window, so the captured Target
+ * at any recorded time can be found after seeking without replaying property updates.
+ * Once full, the oldest events are folded into the Base event that holds the Target at the start of the window.
+ */
+USTRUCT()
+struct LOCKONTARGET_API FLockOnTargetReplayStream : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+public:
+
+	static constexpr int32 Capacity = 64;
+
+	/**
+	 * Appends the event. Events are expected in chronological order.
+	 * The first event is preceded by the Base event with the Target before it, captured since the recording start.
+	 */
+	void Add(double Time, ELockOnTargetReplayEventType Type, const FTargetInfo& Target, const FTargetInfo& PrevTarget);
+
+	void Reset();
+
+	int32 Num() const { return Events.Num(); }
+
+	//Gets the event by its chronological index.
+	const FLockOnTargetReplayEvent& operator[](int32 Index) const { return Events[Index]; }
+
+	//Binary searches the chronological index of the last event at or before the time. INDEX_NONE if there is no such event.
+	int32 FindLastEventIndex(double Time) const;
+
+	//Gets the captured Target at the demo time. Null if nothing was captured or the time precedes the recorded window.
+	FTargetInfo GetTargetAtTime(double Time) const;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FLockOnTargetReplayEvent, FLockOnTargetReplayStream>(Events, DeltaParms, *this);
+	}
+
+private:
+
+	UPROPERTY()
+	TArray<FLockOnTargetReplayEvent> Events;
+};
+
+template<>
+struct TStructOpsTypeTraits<FLockOnTargetReplayStream> : public TStructOpsTypeTraitsBase2<FLockOnTargetReplayStream>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
 /**
  * The types of exceptions/interrupts that Targets can dispatch to Invaders. Supports event-driven design.
  */
@@ -12,6 +12,8 @@ class UTargetComponent;
 class USceneComponent;
 class UTargetManager;
 class UUserWidget;
+enum class EUpdateTransformFlags : int32;
+enum class ETeleportType : uint8;
 
 DECLARE_DYNAMIC_MULTICAST_SPARSE_DELEGATE_OneParam(FOnTargetComponentCaptured, UTargetComponent, OnTargetComponentCaptured, class ULockOnTargetComponent*, Instigator);
 DECLARE_DYNAMIC_MULTICAST_SPARSE_DELEGATE_OneParam(FOnTargetComponentReleased, UTargetComponent, OnTargetComponentReleased, class ULockOnTargetComponent*, Instigator);
@@ -25,6 +27,20 @@ enum class ETargetFocusPointType : uint8
 	Custom			UMETA(ToolTip = "GetCustomFocusPoint() will be called. ")
 };
 
+/** Cached world location of the Socket. */
+struct FTargetSocketLocationCache
+{
+	FName Socket = NAME_None;
+
+	//The bone index within the associated skinned mesh. INDEX_NONE if the Socket isn't a bone.
+	int32 BoneIndex = INDEX_NONE;
+
+	FVector Location = FVector::ZeroVector;
+
+	//The frame in which the Location was cached.
+	uint64 Frame = TNumericLimits<uint64>::Max();
+};
+
 /**
  * TargetComponent gives LockOnTargetComponent the ability to capture it with one of available sockets.
  * Can be used as a storage for the Target specific data.
@@ -124,6 +140,12 @@ private:
 	//The component used for Socket lookup, attachment and etc.
 	TWeakObjectPtr<USceneComponent> AssociatedComponent;
 
+	//Socket locations cached once per frame. Parallel to Sockets.
+	mutable TArray<FTargetSocketLocationCache, TInlineAllocator<4>> SocketsCache;
+
+	FDelegateHandle AssociatedComponentTransformUpdatedHandle;
+	FDelegateHandle AssociatedComponentBoneTransformsFinalizedHandle;
+
 public: /** Target State */
 
 	/** Can the Target be captured by ULockOnTargetComponent. */
@@ -171,7 +193,7 @@ public: /** Sockets */
 	UFUNCTION(BlueprintPure, Category = "Target")
 	const TArray<FName>& GetSockets() const { return Sockets; }
 
-	/** Returns the world location of the given Socket. */
+	/** Returns the world location of the given Socket. Target Sockets are cached once per frame. */
 	UFUNCTION(BlueprintPure, Category = "Target")
 	FVector GetSocketLocation(FName Socket) const;
 
@@ -221,6 +243,21 @@ public: /** Communication */
 	//Dispatch an exception/interrupt message to the Invaders.
 	void DispatchTargetException(ETargetExceptionType Exception);
 
+private:
+
+	//Immediately mirrors the state into the TargetManager, so it's visible within the same frame.
+	void RefreshTargetManagerData();
+
+	//Resolves Sockets to bone indices and resets cached locations.
+	void RebuildSocketsCache();
+	void InvalidateSocketsCache() const;
+	FVector CalcSocketLocation(FName Socket, int32 BoneIndex) const;
+
+	void BindAssociatedComponent();
+	void UnbindAssociatedComponent();
+	void OnAssociatedComponentTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+	void OnAssociatedComponentBoneTransformsFinalized();
+
 public: /** Overrides */
 
 	//UActorComponent
@@ -48,11 +48,41 @@ public:
 	TObjectPtr<UObject> Payload = nullptr;
 };
 
+/**
+ * Identifies an asynchronous FindTarget request. Native only, as async requests aren't exposed to Blueprint.
+ */
+USTRUCT()
+struct LOCKONTARGET_API FFindTargetRequestHandle
+{
+	GENERATED_BODY()
+
+public:
+
+	bool IsValid() const { return Id != 0; }
+	void Invalidate() { Id = 0; }
+
+	static FFindTargetRequestHandle GenerateNewHandle();
+
+	bool operator==(const FFindTargetRequestHandle& Other) const { return Id == Other.Id; }
+	bool operator!=(const FFindTargetRequestHandle& Other) const { return Id != Other.Id; }
+	friend uint32 GetTypeHash(const FFindTargetRequestHandle& Handle) { return ::GetTypeHash(Handle.Id); }
+
+private:
+
+	uint32 Id = 0;
+};
+
+/** Executed once the asynchronous FindTarget request is completed. Isn't executed for cancelled requests. */
+DECLARE_DELEGATE_TwoParams(FOnFindTargetRequestCompleted, FFindTargetRequestHandle /*Handle*/, const FFindTargetRequestResponse& /*Response*/);
+
 /**
  * Special abstract LockOnTargetExtension which is used to handle the Target.
  * Responsible for finding and maintaining the Target.
  * 
  * It's recommended to override FindTarget(), CheckTargetState() and HandleTargetException().
+ * 
+ * Targets are requested asynchronously through RequestFindTargetAsync(). By default, the request is completed immediately by FindTarget().
+ * Override FindTargetAsync() to spread the work across frames and call CompleteFindTargetRequest() once the Target is found.
  */
 UCLASS(Blueprintable, ClassGroup = (LockOnTarget), Abstract, DefaultToInstanced, EditInlineNew, HideDropdown)
 class LOCKONTARGET_API UTargetHandlerBase : public ULockOnTargetExtensionProxy
@@ -94,9 +124,47 @@ public: /** Target Handler Interface */
 	UFUNCTION(BlueprintCallable, Category = "LockOnTarget|Target Handler Base")
 	bool IsTargetValid(const UTargetComponent* Target) const;
 
+public: /** Async Requests */
+
+	/**
+	 * Starts an asynchronous FindTarget request.
+	 * 
+	 * @param	RequestParams	A set of optional params for the request.
+	 * @param	OnCompleted		Executed once the request is completed. May be executed within this call.
+	 * @return	Handle of the request. Can be used to cancel the request.
+	 */
+	FFindTargetRequestHandle RequestFindTargetAsync(const FFindTargetRequestParams& RequestParams, FOnFindTargetRequestCompleted OnCompleted);
+
+	/** Cancels the request. Its delegate won't be executed. */
+	void CancelFindTargetRequest(FFindTargetRequestHandle Handle);
+
+	/** Cancels all pending requests. */
+	void CancelAllFindTargetRequests();
+
+	/** Whether the request is still in progress. */
+	bool IsFindTargetRequestPending(FFindTargetRequestHandle Handle) const { return PendingRequests.Contains(Handle); }
+
+protected:
+
+	/** Processes the request. The default implementation completes it immediately using FindTarget(). */
+	virtual void FindTargetAsync(FFindTargetRequestHandle Handle, const FFindTargetRequestParams& RequestParams);
+
+	/** Completes the pending request and executes its delegate. Unknown and cancelled requests are ignored. */
+	void CompleteFindTargetRequest(FFindTargetRequestHandle Handle, const FFindTargetRequestResponse& Response);
+
+	/** Called when the pending request is cancelled. Any work related to it should be dropped. */
+	virtual void OnFindTargetRequestCancelled(FFindTargetRequestHandle Handle) {}
+
 private: /** Internal */
 
+	TMap<FFindTargetRequestHandle, FOnFindTargetRequestCompleted> PendingRequests;
+
 	virtual FFindTargetRequestResponse FindTarget_Implementation(const FFindTargetRequestParams& RequestParams);
 	virtual void CheckTargetState_Implementation(const FTargetInfo& Target, float DeltaTime);
 	virtual void HandleTargetException_Implementation(const FTargetInfo& Target, ETargetExceptionType Exception);
+
+public: /** Overrides */
+
+	//LockOnTargetExtensionProxy
+	virtual void Deinitialize(ULockOnTargetComponent* Instigator) override;
 };
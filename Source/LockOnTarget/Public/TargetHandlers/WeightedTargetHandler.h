@@ -4,17 +4,24 @@
 
 #include "TargetHandlers/TargetHandlerBase.h"
 #include "Engine/EngineTypes.h"
+#include "WorldCollision.h"
+#include "Tasks/Task.h"
 #include <type_traits>
 #include "WeightedTargetHandler.generated.h"
 
 struct FTargetInfo;
 struct FTargetContext;
 struct FFindTargetContext;
+struct FRegisteredTargetsData;
+struct FCollisionQueryParams;
 class UWeightedTargetHandler;
 class UTargetComponent;
 class ULockOnTargetComponent;
 class APlayerController;
 class APawn;
+class USceneComponent;
+enum class EUpdateTransformFlags : int32;
+enum class ETeleportType : uint8;
 
 /** Target unlock reasons. */
 UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
@@ -81,11 +88,46 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category = "Target Context")
 	float DeltaAngle2D = 0.f;
 
+	//UTargetComponent::Priority.
+	UPROPERTY(BlueprintReadOnly, Category = "Target Context")
+	float Priority = 0.f;
+
 	//The weight calculated for the Target.
 	UPROPERTY(BlueprintReadOnly, Category = "Target Context")
 	float Weight = TNumericLimits<float>::Max();
 };
 
+/**
+ * Plain copy of the UWeightedTargetHandler solver settings.
+ * Calculates weights for a batch of Targets 4 at a time using SIMD, without calling into the handler.
+ * Produces the same weights as UWeightedTargetHandler::CalculateTargetWeight_Implementation(), up to the acos approximation error (~0.004 deg).
+ */
+struct LOCKONTARGET_API FWeightedTargetSolverParams
+{
+public:
+
+	//Direction to compare the Target direction with.
+	FVector3f SolverViewDirection = FVector3f::ForwardVector;
+
+	//PureDefaultWeight * FactorWeight / WeightSum. Zero if the factor isn't used.
+	float DistanceScale = 0.f;
+	float DeltaAngleScale = 0.f;
+	float PlayerInputScale = 0.f;
+	float PriorityScale = 0.f;
+
+	//Inverse max factors.
+	float InvDistanceMaxFactorSq = 0.f;
+	float InvDeltaAngleMaxFactor = 0.f;
+	float InvPlayerInputAngularRange = 0.f;
+
+	float MinimumFactorThreshold = 0.f;
+
+public:
+
+	//Calculates and writes weights for all Targets.
+	void Solve(TArrayView<FTargetContext> TargetsData) const;
+};
+
 /**
  * Possible modes of the FindTarget context.
  */
@@ -134,6 +176,12 @@ public: /** General */
 	UPROPERTY(BlueprintReadOnly, Category = "Find Target Context")
 	FVector2D PlayerInputDirection = FVector2D(1.f, 0.f);
 
+	//Whether the response can be deferred. Only async requests can be deferred.
+	bool bAllowDeferredResponse = false;
+
+	//Whether the passes update LockOnTarget stats. Disabled for internal searches, e.g. the switch neighbour graph.
+	bool bTrackStats = true;
+
 public: /** Captured Target */
 
 	//Currently captured Target by the Instigator, if one exists.
@@ -166,12 +214,16 @@ public: /** View Info */
  * Target finding is performed in 4 main passes:
  * 1. PrimarySampling - quickly rejects all invalid Targets.
  * 2. Solver - calculates weights for remaining Targets.
- * 3. Sort - sorts remaining Targets by weight in ascending order.
+ * 3. Sort - sorts remaining Targets by weight in ascending order. Only builds a min-heap unless a detailed response is requested.
  * 4. SecondarySampling - finds the first Target that passes the remaining checks.
  * 
  * Override CalculateTargetWeight() to use custom weight calculation logic.
+ * Unless it's overridden in Blueprint, weights are calculated natively in batches (see FWeightedTargetSolverParams).
+ * Native subclasses use CalculateTargetWeight() unless they opt in to the batched solver by overriding CanUseBatchedSolver().
  * Override ShouldSkipTargetCustom() to add custom rejection logic.
  * 
+ * With bAsyncSecondarySampling, async requests trace the line of sight of the best candidates in batches, one batch per frame, until a visible one is found.
+ * 
  * Upon request, all targets with calculated weights can be stored in a detailed response.
  * To retrieve a detailed response, set FFindTargetRequestParams::bGenerateDetailedResponse to true.
  * Cast the payload object from the response to the UWeightedTargetHandlerDetailedResponse.
@@ -232,6 +284,13 @@ public: /** Solver */
 	UPROPERTY(EditDefaultsOnly, Category = "Solver", meta = (ClampMin = 0.f, ClampMax = 1.f, Units = "x"))
 	float MinimumFactorThreshold;
 
+	/**
+	 * Calculates weights and sorts Targets on a worker thread for async requests. The secondary pass is finished on the game thread in the next frames.
+	 * Only applies if the batched solver can be used (see CanUseBatchedSolver()).
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Solver")
+	bool bAsyncSolver;
+
 public: /** Distance */
 
 	/** Target must be within a certain distance range. */
@@ -257,6 +316,13 @@ public: /** Distance */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Distance", meta = (EditCondition = "bDistanceCheck", EditConditionHides, ClampMin = 0.f, Units = "x"))
 	float CaptureRadiusScale;
 
+	/**
+	 * Validates the captured Target distance only after the root component of the owner or the Target owner has moved, instead of each check.
+	 * Cuts the idle cost of stationary fights. View offsets that don't move the owner, e.g. a camera lag, are only accounted with the next movement.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Distance", meta = (EditCondition = "bDistanceCheck", EditConditionHides))
+	bool bEventDrivenDistanceCheck;
+
 public: /** View */
 
 	/** The angle of the cone relative to the view direction within which the Target must be. */
@@ -293,6 +359,22 @@ public: /** Target Switching */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "TargetSwitching", meta = (ClampMin = 0.f, ClampMax = 180.f, Units = "deg"))
 	float PlayerInputAngularRange;
 
+	/**
+	 * Keeps the best Target in each of 8 screen-space directions around the captured Target.
+	 * Switching then becomes a lookup by the player input direction. Falls back to the full search if the neighbour is invalid or not visible.
+	 * The graph is rebuilt lazily by the first switch after it has become outdated.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "TargetSwitching")
+	bool bSwitchNeighbourGraph;
+
+	/** The maximum age of the neighbour graph before the next switch rebuilds it. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "TargetSwitching", meta = (EditCondition = "bSwitchNeighbourGraph", EditConditionHides, ClampMin = 0.f, Units = "s"))
+	float SwitchNeighbourGraphInterval;
+
+	/** The next switch rebuilds the neighbour graph once the view or the captured Target moves farther than this distance. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "TargetSwitching", meta = (EditCondition = "bSwitchNeighbourGraph", EditConditionHides, ClampMin = 0.f, Units = "cm"))
+	float SwitchNeighbourGraphMovementThreshold;
+
 public: /** Line Of Sight */
 
 	/** Target must be successfully traced without hitting any objects. The Target and Owner will be ignored. */
@@ -311,11 +393,86 @@ public: /** Line Of Sight */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "LineOfSight", meta = (EditCondition = "bLineOfSightCheck && LostTargetDelay > 0", EditConditionHides, Units = "s"))
 	float CheckInterval;
 
+	/** Traces the captured Target asynchronously. The result is applied the next frame. Only one trace is in flight at a time. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "LineOfSight", meta = (EditCondition = "bLineOfSightCheck && LostTargetDelay > 0", EditConditionHides))
+	bool bAsyncLineOfSight;
+
+	/**
+	 * Traces the best weighted candidates asynchronously in a single batch instead of tracing them one by one.
+	 * Only applies to async requests, which are completed the next frame. Doesn't apply to detailed responses.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "LineOfSight", meta = (EditCondition = "bLineOfSightCheck", EditConditionHides))
+	bool bAsyncSecondarySampling;
+
+	/** The maximum number of candidates traced in a batch. If all of them are occluded, the next best candidates are traced in the next batch. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "LineOfSight", meta = (EditCondition = "bLineOfSightCheck && bAsyncSecondarySampling", EditConditionHides, ClampMin = 1))
+	int32 AsyncSecondarySamplingBatchSize;
+
 private: /** Internal */
 
 	FTimerHandle LineOfSightExpirationHandle;
 	float LineOfSightCheckTimer;
 
+	//The captured Target trace in flight.
+	FTraceHandle LineOfSightTraceHandle;
+	FTraceDelegate LineOfSightTraceDelegate;
+
+	//The async request in progress. Only one is processed at a time.
+	FFindTargetRequestHandle AsyncRequestHandle;
+
+	//Solver and sort passes running on a worker thread.
+	UE::Tasks::TTask<TArray<FTargetContext>> AsyncSolverTask;
+
+	//The context of the async solver request.
+	UPROPERTY(Transient)
+	FFindTargetContext AsyncSolverContext;
+
+	//Keeps Targets processed by the async solver alive, as the task data isn't visible to GC.
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UTargetComponent>> AsyncSolverTargets;
+
+	FTimerHandle AsyncSolverPollHandle;
+
+	//The context of the deferred secondary pass.
+	UPROPERTY(Transient)
+	FFindTargetContext DeferredContext;
+
+	//Candidates of the deferred secondary pass not traced yet. A heap by weight.
+	UPROPERTY(Transient)
+	TArray<FTargetContext> DeferredRemainingCandidates;
+
+	//Candidates of the current batch of the deferred secondary pass in weight order.
+	UPROPERTY(Transient)
+	TArray<FTargetContext> DeferredCandidates;
+
+	//Traces of DeferredCandidates and their results.
+	TArray<FTraceHandle> DeferredTraceHandles;
+	TBitArray<> DeferredVisibility;
+	int32 DeferredPendingTracesNum;
+	FTraceDelegate DeferredTraceDelegate;
+
+	//The best Target in each screen-space direction around SwitchNeighbourGraphTarget. 45 degree steps of the player input starting from the right.
+	UPROPERTY(Transient)
+	FTargetInfo SwitchNeighbours[8];
+
+	//The captured Target the neighbour graph is built for.
+	UPROPERTY(Transient)
+	FTargetInfo SwitchNeighbourGraphTarget;
+
+	//Set once the owner or the captured Target owner moves. Always set if bEventDrivenDistanceCheck is disabled.
+	bool bDistanceCheckPending;
+
+	//Root components whose movement sets bDistanceCheckPending.
+	TWeakObjectPtr<USceneComponent> OwnerRootComponent;
+	TWeakObjectPtr<USceneComponent> TargetRootComponent;
+	FDelegateHandle OwnerTransformUpdatedHandle;
+	FDelegateHandle TargetTransformUpdatedHandle;
+
+	//The state the neighbour graph was built in.
+	float SwitchNeighbourGraphTime;
+	FVector SwitchNeighbourGraphViewLocation;
+	FVector SwitchNeighbourGraphTargetLocation;
+
 protected: /** Finding */
 
 	/** The actual FindTarget() implementation. */
@@ -324,8 +481,8 @@ protected: /** Finding */
 	/** Quickly rejects all invalid Targets. */
 	void PerformPrimarySamplingPass(FFindTargetContext& Context, TArray<FTargetContext>& OutTargetsData);
 
-	/** Whether to skip the Target during the primary pass. */
-	bool ShouldSkipTargetPrimaryPass(const FFindTargetContext& Context, const UTargetComponent* Target) const;
+	/** Whether to skip the Target during the primary pass. Only reads the packed data of the TargetManager. Expects Targets to be culled by the capture radius query. */
+	bool ShouldSkipTargetPrimaryPass(const FFindTargetContext& Context, const FRegisteredTargetsData& TargetsData, int32 Index) const;
 
 	/** Calculates the weight for each Target. */
 	void PerformSolverPass(FFindTargetContext& Context, TArray<FTargetContext>& InOutTargetsData);
@@ -335,11 +492,37 @@ protected: /** Finding */
 	float CalculateTargetWeight(const FFindTargetContext& Context, const FTargetContext& TargetContext) const;
 	virtual float CalculateTargetWeight_Implementation(const FFindTargetContext& Context, const FTargetContext& TargetContext) const;
 
-	/** Finds the first Target that passes the remaining checks. */
+	/**
+	 * Whether weights can be calculated by the batched solver instead of CalculateTargetWeight().
+	 * False if it's overridden in Blueprint or the handler is a native subclass, as native overrides can't be detected.
+	 */
+	virtual bool CanUseBatchedSolver() const;
+
+	/** Copies the solver settings for the context. */
+	FWeightedTargetSolverParams MakeSolverParams(const FFindTargetContext& Context) const;
+
+	/** Finds the first Target that passes the remaining checks. Expects sorted Targets for the detailed response and a heap otherwise. */
 	FFindTargetRequestResponse PerformSecondarySamplingPass(FFindTargetContext& Context, TArray<FTargetContext>& InTargetsData);
 
 	/** Whether to skip the Target during the secondary pass. */
-	bool ShouldSkipTargetSecondaryPass(const FFindTargetContext& Context, const FTargetContext& TargetContext) const;
+	bool ShouldSkipTargetSecondaryPass(const FFindTargetContext& Context, const FTargetContext& TargetContext, bool bCheckLineOfSight = true) const;
+
+	/** Sends async line of sight traces for the best candidates. The request is completed when all of them are completed. */
+	void PerformDeferredSecondarySamplingPass(FFindTargetContext& Context, TArray<FTargetContext>& InTargetsData);
+	bool TraceNextDeferredBatch();
+	void OnDeferredLineOfSightTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+	void ResolveDeferredSecondarySampling();
+	void CancelDeferredSecondarySampling();
+
+	/** Snapshots the sampled Targets and launches the solver and sort passes on a worker thread. */
+	void LaunchAsyncSolver(FFindTargetContext& Context, TArray<FTargetContext>&& TargetsData);
+	void PollAsyncSolver();
+
+	/** Completes the async request unless the secondary pass was deferred. */
+	void CompleteOrDeferAsyncRequest(const FFindTargetRequestResponse& Response);
+
+	/** Drops all work of the async request in progress. */
+	void CancelAsyncRequest();
 
 	/** Whether to skip the Target during the secondary pass. */
 	UFUNCTION(BlueprintNativeEvent, Category = "LockOnTarget|WeightedTargetHandler")
@@ -349,6 +532,24 @@ protected: /** Finding */
 	/** Generates a detailed response based on the data. */
 	virtual UWeightedTargetHandlerDetailedResponse* GenerateDetailedResponse(const FFindTargetContext& Context, TArray<FTargetContext>& InTargetsData);
 
+protected: /** Switch Neighbour Graph */
+
+	/**
+	 * Looks up the neighbour of the captured Target in the player input direction. Returns false if the full search is required.
+	 * Rebuilds the graph first if it's outdated.
+	 */
+	bool TryFindSwitchNeighbour(const FFindTargetRequestParams& RequestParams, FFindTargetRequestResponse& OutResponse);
+
+	/** Whether the neighbour graph was built for another Target, is too old or the view or the Target has moved too far since. */
+	bool IsSwitchNeighbourGraphOutdated(const FFindTargetContext& Context) const;
+
+	/** Runs the primary pass once and picks the best Target for each direction. Line of sight is left to the lookup. */
+	void RebuildSwitchNeighbourGraph(FFindTargetContext Context);
+	void ResetSwitchNeighbourGraph();
+
+	/** Returns the index of the direction in SwitchNeighbours closest to the given one. */
+	static int32 GetSwitchNeighbourDirectionIndex(const FVector2D& Direction);
+
 protected: /** Helpers */
 
 	/** Handles target unlock events. */
@@ -363,6 +564,7 @@ protected: /** Helpers */
 
 	/** Creates and initially populates TargetContext. */
 	FTargetContext CreateTargetContext(const FFindTargetContext& Context, const FTargetInfo& InTarget);
+	FTargetContext CreateTargetContext(const FFindTargetContext& Context, const FTargetInfo& InTarget, const FVector& SocketLocation);
 
 	/** Calculates the delta angle 2D between the player's input and the direction towards the Target. */
 	void CalcDeltaAngle2D(const FFindTargetContext& Context, FTargetContext& OutTargetContext) const;
@@ -378,12 +580,24 @@ protected: /** Helpers */
 	void GetPointOfView(FVector& OutLocation, FRotator& OutRotation) const;
 	virtual void GetPointOfView_Implementation(FVector& OutLocation, FRotator& OutRotation) const;
 
+protected: /** Distance */
+
+	/** Subscribes to the movement of the owner and the Target owner. */
+	void BindDistanceCheckEvents(const UTargetComponent* Target);
+	void UnbindDistanceCheckEvents();
+	void OnDistanceCheckTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
 protected: /** Line Of Sight */
 
 	virtual void StartLineOfSightTimer();
 	virtual void StopLineOfSightTimer();
 	virtual void OnLineOfSightTimerExpired();
 	bool LineOfSightTrace(const FVector& From, const FVector& To, const AActor* const TargetToIgnore) const;
+	FCollisionQueryParams MakeLineOfSightQueryParams(const AActor* const TargetToIgnore) const;
+
+	/** Requests an async trace of the captured Target unless one is in flight. */
+	void RequestAsyncLineOfSightTrace(const FVector& From, const FVector& To, const AActor* const TargetToIgnore);
+	void OnAsyncLineOfSightTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
 
 protected: /** Overrides */
 
@@ -391,8 +605,11 @@ protected: /** Overrides */
 	virtual FFindTargetRequestResponse FindTarget_Implementation(const FFindTargetRequestParams& RequestParams) override;
 	virtual void CheckTargetState_Implementation(const FTargetInfo& Target, float DeltaTime) override;
 	virtual void HandleTargetException_Implementation(const FTargetInfo& Target, ETargetExceptionType Exception) override;
+	virtual void FindTargetAsync(FFindTargetRequestHandle Handle, const FFindTargetRequestParams& RequestParams) override;
+	virtual void OnFindTargetRequestCancelled(FFindTargetRequestHandle Handle) override;
 
 	//LockOnTargetModuleBase
+	virtual void OnTargetLocked(UTargetComponent* Target, FName Socket) override;
 	virtual void OnTargetUnlocked(UTargetComponent* UnlockedTarget, FName Socket) override;
 };
 
@@ -7,13 +7,133 @@
 #include "TargetManager.generated.h"
 
 class UTargetComponent;
+class ULockOnTargetComponent;
 class UWorld;
+class AActor;
 
-/** 
+/**
+ * Packed per-Target data mirrored from registered Targets in a structure-of-arrays layout.
+ * Lets sampling passes reject Targets without chasing pointers. All arrays share the same indexing.
+ *
+ * @Note: Mirrors the state of the last frame. Sampling passes must re-validate Targets they actually use.
+ */
+struct LOCKONTARGET_API FRegisteredTargetsData
+{
+public:
+
+	TArray<UTargetComponent*> Targets;
+
+	//Owning Actors of Targets.
+	TArray<const AActor*> Owners;
+
+	//Owner locations.
+	TArray<FVector> Locations;
+
+	//Custom capture radii. Negative if the default radius should be used.
+	TArray<float> CaptureRadii;
+
+	TArray<float> Priorities;
+
+	//UTargetComponent::CanBeCaptured().
+	TBitArray<> CanBeCaptured;
+
+	//AActor::GetLastRenderTime().
+	TArray<float> LastRenderTimes;
+
+	TArray<int32> SocketsNum;
+
+public:
+
+	int32 Num() const { return Targets.Num(); }
+	bool IsValidIndex(int32 Index) const { return Targets.IsValidIndex(Index); }
+
+	//Adds a new entry and returns its index.
+	int32 Add(UTargetComponent* Target);
+
+	//Removes the entry by moving the last one in its place.
+	void RemoveAtSwap(int32 Index);
+
+	//Mirrors the current state of the Target.
+	void Refresh(int32 Index);
+
+	//Returns the world location of the Socket by its index in UTargetComponent::GetSockets(). See UTargetComponent::GetSocketLocation().
+	FVector GetSocketLocation(int32 Index, int32 SocketIndex) const;
+
+	void Reset();
+};
+
+/**
+ * A uniform grid on the XY plane that buckets indices of FRegisteredTargetsData by their owner location.
+ * Levels are usually much wider than taller, so the Z axis isn't partitioned.
+ * The cell of each index is stored by the caller, so the grid may hold any subset of indices.
+ */
+struct LOCKONTARGET_API FTargetSpatialGrid
+{
+public:
+
+	explicit FTargetSpatialGrid(float InCellSize = 2500.f);
+
+	//Adds the index to the cell containing the location. Returns the cell coords.
+	FIntPoint Add(int32 Index, const FVector& Location);
+
+	//Removes the index from the cell.
+	void Remove(int32 Index, const FIntPoint& Coords);
+
+	//Relocates the index if it has left its cell.
+	void Update(int32 Index, const FVector& Location, FIntPoint& InOutCoords);
+
+	//Renames the index within its cell, e.g. when the last entry of FRegisteredTargetsData is moved.
+	void Rename(int32 OldIndex, int32 NewIndex, const FIntPoint& Coords);
+
+	//Removes all indices.
+	void Reset();
+
+	//Gathers all indices whose location is within the sphere.
+	void QuerySphere(const FVector& Origin, float Radius, TConstArrayView<FVector> Locations, TArray<int32>& OutIndices) const;
+
+	float GetCellSize() const { return CellSize; }
+	int32 GetCellsNum() const { return Cells.Num(); }
+
+private:
+
+	FIntPoint GetCellCoords(const FVector& Location) const;
+
+	float CellSize;
+	float InvCellSize;
+
+	//Non-empty cells.
+	TMap<FIntPoint, TArray<int32>> Cells;
+};
+
+/**
+ * Targets sharing the same capture radius, indexed by their own spatial grid.
+ * Allows a single sphere query per distinct capture radius.
+ */
+struct LOCKONTARGET_API FTargetCaptureRadiusBucket
+{
+public:
+
+	FTargetCaptureRadiusBucket(float InCaptureRadius, float CellSize)
+		: CaptureRadius(InCaptureRadius)
+		, Grid(CellSize)
+	{
+	}
+
+	//The custom capture radius of Targets. Negative for Targets using the default radius.
+	float CaptureRadius;
+
+	int32 TargetsNum = 0;
+
+	FTargetSpatialGrid Grid;
+};
+
+/**
  * A simple manager that keeps track of registered Targets.
+ * Mirrors Targets data into a packed structure and indexes it by spatial grids grouped by the capture radius. Both are refreshed each frame.
+ * Also time-slices CheckTargetState() of scheduled instigators within a per-frame budget. LockOnTarget.TargetStateCheckBudget.
  */
 UCLASS()
-class LOCKONTARGET_API UTargetManager final : public UWorldSubsystem
+class LOCKONTARGET_API UTargetManager final : public UTickableWorldSubsystem
 {
 	GENERATED_BODY()
 
@@ -22,18 +142,72 @@ public:
 	UTargetManager();
 	static UTargetManager& Get(UWorld& InWorld);
 
+	//The size of the spatial grid cell of the default capture radius bucket. Should be about the size of the commonly used capture radius.
+	static constexpr float SpatialGridCellSize = 2500.f;
+
+	//Custom capture radius buckets use the radius as the cell size, but not less than this.
+	static constexpr float MinSpatialGridCellSize = 500.f;
+
+	//The bucket of Targets using the default capture radius. Always exists.
+	static constexpr int32 DefaultCaptureRadiusBucket = 0;
+
 private: /** Internal */
 
 	//All registered Targets.
 	TSet<UTargetComponent*> RegisteredTargets;
 
-public: 
+	//Index of each registered Target in TargetsData.
+	TMap<UTargetComponent*, int32> TargetIndices;
+
+	//The first registered Target of each owner.
+	TMap<const AActor*, UTargetComponent*> OwnerTargets;
+
+	//Packed data of registered Targets.
+	FRegisteredTargetsData TargetsData;
+
+	//TargetsData grouped by the capture radius and indexed by the owner location.
+	TArray<FTargetCaptureRadiusBucket> CaptureRadiusBuckets;
+
+	//The capture radius bucket of each entry of TargetsData.
+	TArray<int32> TargetBuckets;
+
+	//The grid cell of each entry of TargetsData within its bucket.
+	TArray<FIntPoint> TargetCells;
+
+	struct FScheduledTargetStateCheck
+	{
+		//Null if unregistered. Removed before the next processing.
+		TWeakObjectPtr<ULockOnTargetComponent> Instigator;
+
+		//World time of the last check.
+		double LastCheckTime = 0.0;
+	};
+
+	//Instigators checked in a round-robin order.
+	TArray<FScheduledTargetStateCheck> ScheduledTargetStateChecks;
+
+	//The next instigator to check.
+	int32 NextTargetStateCheck;
+
+public:
 
 	//Target registration
 	bool RegisterTarget(UTargetComponent* Target);
 	bool UnregisterTarget(UTargetComponent* Target);
 	bool IsTargetRegistered(UTargetComponent * Target) const { return RegisteredTargets.Contains(Target); }
 
+	//Immediately mirrors the Target state instead of waiting for the next frame.
+	void RefreshTarget(UTargetComponent* Target);
+
+	//Gets the registered Target of the owner without scanning its components.
+	UTargetComponent* FindTargetByOwner(const AActor* Owner) const { return OwnerTargets.FindRef(Owner); }
+
+	/**
+	 * Gets the Target of the owner. Looks up the registered Targets of the owner world first,
+	 * falls back to FindComponentByClass() if the Target isn't registered yet, e.g. its owner hasn't begun play.
+	 */
+	static UTargetComponent* FindTargetComponent(const AActor* Owner);
+
 	//Gets all registered Targets
 	UFUNCTION(BlueprintCallable, Category = "LockOnTarget Manager")
 	const TSet<UTargetComponent*>& GetRegisteredTargets() const { return RegisteredTargets; }
@@ -42,9 +216,70 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "LockOnTarget Manager")
 	int32 GetRegisteredTargetsNum() const { return RegisteredTargets.Num(); }
 
+	//Gets the packed data of registered Targets.
+	const FRegisteredTargetsData& GetTargetsData() const { return TargetsData; }
+
+	//Gets the index of the registered Target in TargetsData. INDEX_NONE if not registered. Valid until the next unregistration.
+	int32 GetTargetIndex(UTargetComponent* Target) const
+	{
+		const int32* const Index = TargetIndices.Find(Target);
+		return Index ? *Index : INDEX_NONE;
+	}
+
+	//Gets the world location of the Target Socket. Shared by all instigators within the frame.
+	FVector GetSocketLocation(int32 Index, int32 SocketIndex) const { return TargetsData.GetSocketLocation(Index, SocketIndex); }
+
+	//Gets the number of distinct capture radii among registered Targets, including the default one.
+	int32 GetCaptureRadiusBucketsNum() const { return CaptureRadiusBuckets.Num(); }
+
+public: /** Target State Scheduling */
+
+	//Time-slices CheckTargetState() of the instigator instead of calling it each tick.
+	void ScheduleTargetStateCheck(ULockOnTargetComponent* Instigator);
+	void UnscheduleTargetStateCheck(ULockOnTargetComponent* Instigator);
+
+	int32 GetScheduledTargetStateChecksNum() const { return ScheduledTargetStateChecks.Num(); }
+
+private:
+
+	//Checks as many instigators as fit in the budget, but at least one. Each instigator is checked at most once per frame.
+	void ProcessScheduledTargetStateChecks();
+
+public: /** Spatial Queries */
+
+	//@Note: Owner locations and the grids are refreshed by Tick(), so all queries see the state of the last frame, like FRegisteredTargetsData.
+
+	//Gathers registered Targets whose owner was within the sphere as of the last Tick().
+	UFUNCTION(BlueprintCallable, Category = "LockOnTarget Manager")
+	void QueryTargetsInSphere(const FVector& ViewLocation, float Radius, TArray<UTargetComponent*>& OutTargets) const;
+
+	//Gathers TargetsData indices of Targets whose owner was within the sphere as of the last Tick().
+	void QueryTargetIndicesInSphere(const FVector& ViewLocation, float Radius, TArray<int32>& OutIndices) const;
+
+	/**
+	 * Gathers TargetsData indices of Targets whose owner is within their own capture radius, using a single query per radius bucket.
+	 * Targets without a custom capture radius use DefaultRadius. All radii are multiplied by RadiusScale.
+	 */
+	void QueryTargetIndicesInCaptureRadius(const FVector& ViewLocation, float DefaultRadius, float RadiusScale, TArray<int32>& OutIndices) const;
+
+private:
+
+	int32 FindOrAddCaptureRadiusBucket(float CaptureRadius);
+
+	//Expects the TargetsData entry to be up to date.
+	void AddToCaptureRadiusBucket(int32 Index);
+	void RemoveFromCaptureRadiusBucket(int32 Index);
+
+	//Moves the entry to another bucket if its capture radius has changed, otherwise updates its cell.
+	void UpdateCaptureRadiusBucket(int32 Index);
+
 protected: /** Overrides */
-	
+
 	//UWorldSubsystem
 	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
 	virtual bool DoesSupportWorldType(const EWorldType::Type Type) const override;
+
+	//UTickableWorldSubsystem
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
 };
@@ -0,0 +1,92 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LockOnTargetTypes.h"
+#include "TargetValidationManager.generated.h"
+
+class UTargetComponent;
+class ULockOnTargetComponent;
+struct FTraceHandle;
+struct FTraceDatum;
+
+/**
+ * Validates Target claims of remote instigators on the server as cheap anti-cheat.
+ * The distance is checked synchronously. The visibility is looked up in a short-lived cache of instigator-Target pairs refreshed by async traces,
+ * so a claim never waits for a trace. Traces start from the instigator view point, i.e. the camera the client finds Targets from.
+ * A pair without the cached visibility is accepted. Held pairs are traced periodically and revoked
+ * once they stay occluded longer than the LostTargetDelay of the instigator handler.
+ *
+ * Configured by LockOnTarget.ClaimValidation.* console variables. Disabled by default.
+ */
+UCLASS()
+class LOCKONTARGET_API UTargetValidationManager final : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+private: /** Internal */
+
+	struct FClaimVisibility
+	{
+		TWeakObjectPtr<ULockOnTargetComponent> Instigator;
+		TWeakObjectPtr<UTargetComponent> Target;
+
+		//The Socket of the last claim. Traced by the next refresh.
+		FName Socket = NAME_None;
+
+		//World time of the last trace result.
+		double UpdateTime = -1.0;
+
+		//World time of the last claim. Unclaimed pairs are evicted.
+		double ClaimTime = 0.0;
+
+		//World time of the first failed trace in a row. Negative if the last trace succeeded.
+		double OccludedTime = -1.0;
+
+		bool bTracePending = false;
+
+	public:
+
+		bool IsOccluded() const { return OccludedTime >= 0.0; }
+	};
+
+	using FClaimKey = TPair<const ULockOnTargetComponent*, const UTargetComponent*>;
+
+	//Recent visibility of claimed pairs.
+	TMap<FClaimKey, FClaimVisibility> ClaimVisibilities;
+
+public:
+
+	/**
+	 * Checks the claim of the instigator to capture the Target. Never blocks on a trace.
+	 * Refreshes the cached visibility of the pair asynchronously if it's outdated.
+	 */
+	bool ValidateTargetClaim(ULockOnTargetComponent* Instigator, const FTargetInfo& Target);
+
+	//Gets the number of cached instigator-Target pairs.
+	int32 GetCachedClaimsNum() const { return ClaimVisibilities.Num(); }
+
+	//Whether any validation is enabled.
+	static bool IsClaimValidationEnabled();
+
+private:
+
+	void RequestVisibilityTrace(const FClaimKey& Key, FClaimVisibility& Visibility);
+	void OnVisibilityTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum, FClaimKey Key);
+
+	static void GetInstigatorViewPoint(const AActor* InstigatorOwner, FVector& OutLocation, FRotator& OutRotation);
+
+	//The time a held Target may stay occluded. Matches the LostTargetDelay of UWeightedTargetHandler.
+	static float GetLostDelay(const ULockOnTargetComponent* Instigator);
+
+protected: /** Overrides */
+
+	//UWorldSubsystem
+	virtual bool DoesSupportWorldType(const EWorldType::Type Type) const override;
+
+	//UTickableWorldSubsystem
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+};
@@ -16,7 +16,7 @@ public class LockOnTargetDev : ModuleRules
                 "CoreUObject",
                 "Engine",
                 "InputCore",
-
+                "Json",
             }
             );
 
@@ -0,0 +1,444 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#include "Benchmark/LockOnTargetBenchmarkCommandlet.h"
+#include "Benchmark/LockOnTargetBenchmarkHandler.h"
+#include "LockOnTargetComponent.h"
+#include "TargetComponent.h"
+#include "TargetManager.h"
+
+#include "Components/SceneComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogLockOnTargetBenchmark, Log, All);
+
+namespace
+{
+	struct FBenchmarkSettings
+	{
+		TArray<int32> TargetsNums = { 10, 100, 1000, 10000 };
+		float Density = 0.01f;
+		int32 SocketsNum = 1;
+		int32 Iterations = 200;
+		int32 WarmupIterations = 20;
+		int32 Seed = 0;
+		bool bLineOfSight = false;
+		bool bEventSolver = false;
+		int32 PlayersNum = 0;
+		int32 ComponentsNum = 8;
+		FString OutputPath;
+	};
+
+	//Statistics of a single pass in microseconds.
+	struct FBenchmarkPassStats
+	{
+		double Mean = 0.0;
+		double Min = 0.0;
+		double Median = 0.0;
+		double P95 = 0.0;
+		double Max = 0.0;
+
+		static FBenchmarkPassStats Make(TArray<double>& Samples)
+		{
+			FBenchmarkPassStats Stats;
+
+			if (Samples.Num() > 0)
+			{
+				Samples.Sort();
+
+				double Sum = 0.0;
+
+				for (const double Sample : Samples)
+				{
+					Sum += Sample;
+				}
+
+				const auto Percentile = [&Samples](double Alpha)
+					{
+						return Samples[FMath::Clamp(FMath::CeilToInt(Alpha * Samples.Num()) - 1, 0, Samples.Num() - 1)];
+					};
+
+				Stats.Mean = Sum / Samples.Num();
+				Stats.Min = Samples[0];
+				Stats.Median = Percentile(0.5);
+				Stats.P95 = Percentile(0.95);
+				Stats.Max = Samples.Last();
+			}
+
+			return Stats;
+		}
+	};
+
+	struct FBenchmarkResult
+	{
+		int32 TargetsNum = 0;
+		double AvgCandidatesNum = 0.0;
+		double FoundTargetRatio = 0.0;
+		TArray<TPair<FString, FBenchmarkPassStats>> Passes;
+	};
+
+	FBenchmarkSettings ParseSettings(const FString& Params)
+	{
+		FBenchmarkSettings Settings;
+
+		FString TargetsNums;
+		if (FParse::Value(*Params, TEXT("Targets="), TargetsNums))
+		{
+			TArray<FString> Values;
+			TargetsNums.ParseIntoArray(Values, TEXT(","));
+			Settings.TargetsNums.Reset();
+
+			for (const FString& Value : Values)
+			{
+				const int32 TargetsNum = FCString::Atoi(*Value);
+
+				if (TargetsNum > 0)
+				{
+					Settings.TargetsNums.Add(TargetsNum);
+				}
+			}
+		}
+
+		FParse::Value(*Params, TEXT("Density="), Settings.Density);
+		FParse::Value(*Params, TEXT("Sockets="), Settings.SocketsNum);
+		FParse::Value(*Params, TEXT("Iterations="), Settings.Iterations);
+		FParse::Value(*Params, TEXT("Warmup="), Settings.WarmupIterations);
+		FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+		Settings.bLineOfSight = FParse::Param(*Params, TEXT("LineOfSight"));
+		Settings.bEventSolver = FParse::Param(*Params, TEXT("EventSolver"));
+		FParse::Value(*Params, TEXT("LookupPlayers="), Settings.PlayersNum);
+		FParse::Value(*Params, TEXT("Components="), Settings.ComponentsNum);
+
+		Settings.Density = FMath::Max(Settings.Density, UE_KINDA_SMALL_NUMBER);
+		Settings.SocketsNum = FMath::Max(Settings.SocketsNum, 1);
+		Settings.Iterations = FMath::Max(Settings.Iterations, 1);
+		Settings.WarmupIterations = FMath::Max(Settings.WarmupIterations, 0);
+		Settings.PlayersNum = FMath::Max(Settings.PlayersNum, 0);
+		Settings.ComponentsNum = FMath::Max(Settings.ComponentsNum, 0);
+
+		if (!FParse::Value(*Params, TEXT("Output="), Settings.OutputPath))
+		{
+			Settings.OutputPath = FPaths::ProjectSavedDir() / TEXT("LockOnTarget") / TEXT("Benchmark") / FString::Printf(TEXT("LockOnTargetBenchmark-%s"), *FDateTime::Now().ToString());
+		}
+
+		return Settings;
+	}
+
+	UWorld* CreateBenchmarkWorld()
+	{
+		UWorld* const World = UWorld::CreateWorld(EWorldType::Game, /*bInformEngineOfWorld*/ false, TEXT("LockOnTargetBenchmark"));
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+
+		//There is no GameMode to start the play.
+		if (!World->HasBegunPlay())
+		{
+			World->GetWorldSettings()->NotifyBeginPlay();
+		}
+
+		return World;
+	}
+
+	void DestroyBenchmarkWorld(UWorld* World)
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(/*bInformEngineOfWorld*/ false);
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	AActor* SpawnBenchmarkActor(UWorld& World, const FVector& Location)
+	{
+		AActor* const Actor = World.SpawnActor<AActor>(Location, FRotator::ZeroRotator);
+		check(Actor);
+
+		USceneComponent* const Root = NewObject<USceneComponent>(Actor, TEXT("Root"));
+		Actor->SetRootComponent(Root);
+		Root->RegisterComponent();
+		Actor->SetActorLocation(Location);
+
+		return Actor;
+	}
+
+	void SpawnTargets(UWorld& World, const FBenchmarkSettings& Settings, int32 TargetsNum)
+	{
+		FRandomStream RandomStream(Settings.Seed);
+
+		//Uniformly scatter Targets in a disc with the area matching the density.
+		const float RadiusMeters = FMath::Sqrt(TargetsNum / (Settings.Density * UE_PI));
+		const float Radius = RadiusMeters * 100.f;
+
+		for (int32 i = 0; i < TargetsNum; ++i)
+		{
+			const float Distance = Radius * FMath::Sqrt(RandomStream.FRand());
+			const float Angle = RandomStream.FRandRange(0.f, 2.f * UE_PI);
+			const FVector Location(Distance * FMath::Cos(Angle), Distance * FMath::Sin(Angle), RandomStream.FRandRange(-100.f, 100.f));
+
+			AActor* const Actor = SpawnBenchmarkActor(World, Location);
+			UTargetComponent* const Target = NewObject<UTargetComponent>(Actor, TEXT("Target"));
+
+			for (int32 SocketIndex = 1; SocketIndex < Settings.SocketsNum; ++SocketIndex)
+			{
+				Target->AddSocket(FName(TEXT("Socket"), SocketIndex));
+			}
+
+			Target->RegisterComponent();
+		}
+	}
+
+	FBenchmarkResult RunBenchmark(const FBenchmarkSettings& Settings, int32 TargetsNum)
+	{
+		UWorld* const World = CreateBenchmarkWorld();
+		SpawnTargets(*World, Settings, TargetsNum);
+
+		AActor* const InstigatorActor = SpawnBenchmarkActor(*World, FVector::ZeroVector);
+		ULockOnTargetComponent* const LockOn = NewObject<ULockOnTargetComponent>(InstigatorActor, TEXT("LockOnTarget"));
+		LockOn->RegisterComponent();
+
+		ULockOnTargetBenchmarkHandler* const Handler = LockOn->SetTargetHandlerByClass<ULockOnTargetBenchmarkHandler>();
+		check(Handler);
+		Handler->bLineOfSightCheck = Settings.bLineOfSight;
+		Handler->bBatchedSolver = !Settings.bEventSolver;
+
+		TArray<double> PrimarySampling, Solver, Sort, SecondarySampling, Total;
+		int64 CandidatesNum = 0;
+		int32 FoundTargetsNum = 0;
+		const float DeltaTime = 1.f / 60.f;
+
+		for (int32 Iteration = 0; Iteration < Settings.WarmupIterations + Settings.Iterations; ++Iteration)
+		{
+			//Emulate the engine loop, so per frame caches are refreshed.
+			World->Tick(LEVELTICK_All, DeltaTime);
+			++GFrameCounter;
+
+			//Rotate the view to sample different sectors of the disc.
+			InstigatorActor->SetActorRotation(FRotator(0.f, Iteration * 7.f, 0.f));
+
+			const FLockOnTargetBenchmarkSample Sample = Handler->RunTimedFindTarget();
+
+			if (Iteration >= Settings.WarmupIterations)
+			{
+				constexpr double ToMicroseconds = 1e6;
+				PrimarySampling.Add(Sample.PrimarySampling * ToMicroseconds);
+				Solver.Add(Sample.Solver * ToMicroseconds);
+				Sort.Add(Sample.Sort * ToMicroseconds);
+				SecondarySampling.Add(Sample.SecondarySampling * ToMicroseconds);
+				Total.Add((Sample.PrimarySampling + Sample.Solver + Sample.Sort + Sample.SecondarySampling) * ToMicroseconds);
+				CandidatesNum += Sample.CandidatesNum;
+				FoundTargetsNum += Sample.bFoundTarget;
+			}
+		}
+
+		FBenchmarkResult Result;
+		Result.TargetsNum = TargetsNum;
+		Result.AvgCandidatesNum = static_cast<double>(CandidatesNum) / Settings.Iterations;
+		Result.FoundTargetRatio = static_cast<double>(FoundTargetsNum) / Settings.Iterations;
+		Result.Passes.Emplace(TEXT("PrimarySampling"), FBenchmarkPassStats::Make(PrimarySampling));
+		Result.Passes.Emplace(TEXT("Solver"), FBenchmarkPassStats::Make(Solver));
+		Result.Passes.Emplace(TEXT("Sort"), FBenchmarkPassStats::Make(Sort));
+		Result.Passes.Emplace(TEXT("SecondarySampling"), FBenchmarkPassStats::Make(SecondarySampling));
+		Result.Passes.Emplace(TEXT("Total"), FBenchmarkPassStats::Make(Total));
+
+		DestroyBenchmarkWorld(World);
+		return Result;
+	}
+
+	/**
+	 * Emulates a frame in which each client receives a Target change of every other player's simulated proxy,
+	 * and times resolving the UTargetComponent from the owner, as FTargetInfo::NetSerialize() does after reading it.
+	 * A lookup micro-benchmark only, nothing goes through a package map.
+	 */
+	FBenchmarkResult RunOwnerLookupBenchmark(const FBenchmarkSettings& Settings)
+	{
+		UWorld* const World = CreateBenchmarkWorld();
+		TArray<AActor*> Players;
+
+		for (int32 i = 0; i < Settings.PlayersNum; ++i)
+		{
+			AActor* const Player = Players.Add_GetRef(SpawnBenchmarkActor(*World, FVector(i * 200.f, 0.f, 0.f)));
+
+			//A typical character has a bunch of components before the Target, e.g. a mesh, a capsule, a movement and a camera.
+			for (int32 ComponentIndex = 0; ComponentIndex < Settings.ComponentsNum; ++ComponentIndex)
+			{
+				USceneComponent* const Component = NewObject<USceneComponent>(Player, FName(TEXT("Component"), ComponentIndex));
+				Component->SetupAttachment(Player->GetRootComponent());
+				Component->RegisterComponent();
+			}
+
+			NewObject<UTargetComponent>(Player, TEXT("Target"))->RegisterComponent();
+		}
+
+		TArray<double> FindComponentByClass, TargetManager;
+		const int32 ReceivesNum = Settings.PlayersNum * (Settings.PlayersNum - 1);
+		int64 FoundTargetsNum = 0;
+		const float DeltaTime = 1.f / 60.f;
+
+		const auto TimeReceives = [&Players, &FoundTargetsNum](auto&& Resolve)
+			{
+				const double StartTime = FPlatformTime::Seconds();
+
+				for (const AActor* const Receiver : Players)
+				{
+					for (const AActor* const Owner : Players)
+					{
+						if (Owner != Receiver)
+						{
+							FoundTargetsNum += Resolve(Owner) != nullptr;
+						}
+					}
+				}
+
+				return FPlatformTime::Seconds() - StartTime;
+			};
+
+		for (int32 Iteration = 0; Iteration < Settings.WarmupIterations + Settings.Iterations; ++Iteration)
+		{
+			World->Tick(LEVELTICK_All, DeltaTime);
+			++GFrameCounter;
+
+			const double FindComponentByClassTime = TimeReceives([](const AActor* Owner) { return Owner->FindComponentByClass<UTargetComponent>(); });
+			const double TargetManagerTime = TimeReceives([](const AActor* Owner) { return UTargetManager::FindTargetComponent(Owner); });
+
+			if (Iteration >= Settings.WarmupIterations)
+			{
+				constexpr double ToMicroseconds = 1e6;
+				FindComponentByClass.Add(FindComponentByClassTime * ToMicroseconds);
+				TargetManager.Add(TargetManagerTime * ToMicroseconds);
+			}
+		}
+
+		FBenchmarkResult Result;
+		Result.TargetsNum = Settings.PlayersNum;
+		Result.AvgCandidatesNum = ReceivesNum; //Resolved Targets per frame.
+		Result.FoundTargetRatio = ReceivesNum > 0 ? static_cast<double>(FoundTargetsNum) / (2.0 * ReceivesNum * (Settings.WarmupIterations + Settings.Iterations)) : 0.0;
+		Result.Passes.Emplace(TEXT("FindComponentByClass"), FBenchmarkPassStats::Make(FindComponentByClass));
+		Result.Passes.Emplace(TEXT("TargetManager"), FBenchmarkPassStats::Make(TargetManager));
+
+		DestroyBenchmarkWorld(World);
+		return Result;
+	}
+
+	bool WriteCSV(const FBenchmarkSettings& Settings, const TArray<FBenchmarkResult>& Results)
+	{
+		FString CSV = TEXT("Targets,Sockets,Density,Iterations,LineOfSight,EventSolver,AvgCandidates,FoundTargetRatio,Pass,MeanUs,MinUs,MedianUs,P95Us,MaxUs\n");
+
+		for (const FBenchmarkResult& Result : Results)
+		{
+			for (const TPair<FString, FBenchmarkPassStats>& Pass : Result.Passes)
+			{
+				CSV += FString::Printf(TEXT("%d,%d,%f,%d,%d,%d,%.2f,%.3f,%s,%.3f,%.3f,%.3f,%.3f,%.3f\n"),
+					Result.TargetsNum, Settings.SocketsNum, Settings.Density, Settings.Iterations, Settings.bLineOfSight, Settings.bEventSolver,
+					Result.AvgCandidatesNum, Result.FoundTargetRatio, *Pass.Key,
+					Pass.Value.Mean, Pass.Value.Min, Pass.Value.Median, Pass.Value.P95, Pass.Value.Max);
+			}
+		}
+
+		return FFileHelper::SaveStringToFile(CSV, *(Settings.OutputPath + TEXT(".csv")));
+	}
+
+	bool WriteJSON(const FBenchmarkSettings& Settings, const TArray<FBenchmarkResult>& Results)
+	{
+		const TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+
+		const TSharedRef<FJsonObject> SettingsObject = MakeShared<FJsonObject>();
+		SettingsObject->SetNumberField(TEXT("Sockets"), Settings.SocketsNum);
+		SettingsObject->SetNumberField(TEXT("Density"), Settings.Density);
+		SettingsObject->SetNumberField(TEXT("Iterations"), Settings.Iterations);
+		SettingsObject->SetNumberField(TEXT("Warmup"), Settings.WarmupIterations);
+		SettingsObject->SetNumberField(TEXT("Seed"), Settings.Seed);
+		SettingsObject->SetBoolField(TEXT("LineOfSight"), Settings.bLineOfSight);
+		SettingsObject->SetBoolField(TEXT("EventSolver"), Settings.bEventSolver);
+		SettingsObject->SetNumberField(TEXT("LookupPlayers"), Settings.PlayersNum);
+		SettingsObject->SetNumberField(TEXT("Components"), Settings.ComponentsNum);
+		SettingsObject->SetStringField(TEXT("CommandLine"), FCommandLine::Get());
+		Root->SetObjectField(TEXT("Settings"), SettingsObject);
+
+		TArray<TSharedPtr<FJsonValue>> ResultValues;
+
+		for (const FBenchmarkResult& Result : Results)
+		{
+			const TSharedRef<FJsonObject> ResultObject = MakeShared<FJsonObject>();
+			ResultObject->SetNumberField(TEXT("Targets"), Result.TargetsNum);
+			ResultObject->SetNumberField(TEXT("AvgCandidates"), Result.AvgCandidatesNum);
+			ResultObject->SetNumberField(TEXT("FoundTargetRatio"), Result.FoundTargetRatio);
+
+			const TSharedRef<FJsonObject> PassesObject = MakeShared<FJsonObject>();
+
+			for (const TPair<FString, FBenchmarkPassStats>& Pass : Result.Passes)
+			{
+				const TSharedRef<FJsonObject> PassObject = MakeShared<FJsonObject>();
+				PassObject->SetNumberField(TEXT("MeanUs"), Pass.Value.Mean);
+				PassObject->SetNumberField(TEXT("MinUs"), Pass.Value.Min);
+				PassObject->SetNumberField(TEXT("MedianUs"), Pass.Value.Median);
+				PassObject->SetNumberField(TEXT("P95Us"), Pass.Value.P95);
+				PassObject->SetNumberField(TEXT("MaxUs"), Pass.Value.Max);
+				PassesObject->SetObjectField(Pass.Key, PassObject);
+			}
+
+			ResultObject->SetObjectField(TEXT("Passes"), PassesObject);
+			ResultValues.Add(MakeShared<FJsonValueObject>(ResultObject));
+		}
+
+		Root->SetArrayField(TEXT("Results"), ResultValues);
+
+		FString JSON;
+		const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JSON);
+		return FJsonSerializer::Serialize(Root, Writer) && FFileHelper::SaveStringToFile(JSON, *(Settings.OutputPath + TEXT(".json")));
+	}
+}
+
+ULockOnTargetBenchmarkCommandlet::ULockOnTargetBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 ULockOnTargetBenchmarkCommandlet::Main(const FString& Params)
+{
+	const FBenchmarkSettings Settings = ParseSettings(Params);
+	TArray<FBenchmarkResult> Results;
+
+	const auto LogResult = [](const FBenchmarkResult& Result)
+		{
+			for (const TPair<FString, FBenchmarkPassStats>& Pass : Result.Passes)
+			{
+				UE_LOG(LogLockOnTargetBenchmark, Display, TEXT("\t%-20s mean %9.3f us, median %9.3f us, p95 %9.3f us"), *Pass.Key, Pass.Value.Mean, Pass.Value.Median, Pass.Value.P95);
+			}
+		};
+
+	if (Settings.PlayersNum > 0)
+	{
+		UE_LOG(LogLockOnTargetBenchmark, Display, TEXT("Benchmarking Target owner lookups of %d players..."), Settings.PlayersNum);
+		LogResult(Results.Add_GetRef(RunOwnerLookupBenchmark(Settings)));
+	}
+	else
+	{
+		for (const int32 TargetsNum : Settings.TargetsNums)
+		{
+			UE_LOG(LogLockOnTargetBenchmark, Display, TEXT("Benchmarking %d Targets..."), TargetsNum);
+			LogResult(Results.Add_GetRef(RunBenchmark(Settings, TargetsNum)));
+		}
+	}
+
+	if (!WriteCSV(Settings, Results) || !WriteJSON(Settings, Results))
+	{
+		UE_LOG(LogLockOnTargetBenchmark, Error, TEXT("Failed to write results to %s."), *Settings.OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogLockOnTargetBenchmark, Display, TEXT("Results are written to %s.csv/.json"), *Settings.OutputPath);
+	return 0;
+}
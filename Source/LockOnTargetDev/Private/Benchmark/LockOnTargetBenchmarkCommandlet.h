@@ -0,0 +1,44 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "LockOnTargetBenchmarkCommandlet.generated.h"
+
+/**
+ * Headless benchmark of the WeightedTargetHandler passes.
+ * For each Targets number, spawns a synthetic world with Targets uniformly scattered around the instigator
+ * and times PrimarySampling, Solver, Sort and SecondarySampling passes. Results are written as CSV and JSON.
+ * 
+ * With -LookupPlayers, micro-benchmarks resolving Target owners to Targets instead, i.e. the lookup FTargetInfo::NetSerialize() does on receive.
+ * Each player resolves the Target of every other player per frame. Serialization itself isn't timed.
+ * 
+ * Usage: UnrealEditor-Cmd <Project> -run=LockOnTargetBenchmark -nullrhi -unattended [Options]
+ * 
+ * Options:
+ *	-Targets=10,100,1000,10000	Numbers of Targets to benchmark.
+ *	-Density=0.01				Targets per square meter.
+ *	-Sockets=1					Sockets per Target.
+ *	-Iterations=200				Timed FindTarget iterations per Targets number.
+ *	-Warmup=20					Untimed FindTarget iterations per Targets number.
+ *	-Seed=0						Seed of the Targets placement.
+ *	-LineOfSight				Enable line of sight traces.
+ *	-EventSolver				Calculate weights with CalculateTargetWeight() per Target instead of the batched solver.
+ *	-LookupPlayers=100			Number of players of the owner lookup benchmark.
+ *	-Components=8				Components of each player preceding the Target in the owner lookup benchmark.
+ *	-Output=<Path>				Output path without extension. Defaults to Saved/LockOnTarget/Benchmark/.
+ */
+UCLASS()
+class ULockOnTargetBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	ULockOnTargetBenchmarkCommandlet();
+
+	//UCommandlet
+	virtual int32 Main(const FString& Params) override;
+	//~UCommandlet
+};
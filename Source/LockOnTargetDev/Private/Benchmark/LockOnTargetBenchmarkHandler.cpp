@@ -0,0 +1,62 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#include "Benchmark/LockOnTargetBenchmarkHandler.h"
+
+#include "HAL/PlatformTime.h"
+
+ULockOnTargetBenchmarkHandler::ULockOnTargetBenchmarkHandler()
+{
+	AutoFindTargetFlags = 0;
+	bScreenCapture = false;
+	bRecentRenderCheck = false;
+}
+
+FLockOnTargetBenchmarkSample ULockOnTargetBenchmarkHandler::RunTimedFindTarget()
+{
+	FLockOnTargetBenchmarkSample Sample;
+	FFindTargetContext Context = CreateFindTargetContext(EFindTargetContextMode::Find, FFindTargetRequestParams());
+	TArray<FTargetContext> TargetsData;
+
+	uint64 StartCycles = FPlatformTime::Cycles64();
+	PerformPrimarySamplingPass(Context, /*out*/TargetsData);
+	Sample.PrimarySampling = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+	Sample.CandidatesNum = TargetsData.Num();
+
+	if (TargetsData.Num() > 0)
+	{
+		StartCycles = FPlatformTime::Cycles64();
+		PerformSolverPass(Context, /*inout*/TargetsData);
+		Sample.Solver = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+		//Mirrors the FindTargetBatched() heap, as the detailed response isn't requested.
+		StartCycles = FPlatformTime::Cycles64();
+		TargetsData.Heapify([](const FTargetContext& lhs, const FTargetContext& rhs)
+			{
+				return lhs.Weight < rhs.Weight;
+			});
+		Sample.Sort = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+		StartCycles = FPlatformTime::Cycles64();
+		const FFindTargetRequestResponse Response = PerformSecondarySamplingPass(Context, /*in*/TargetsData);
+		Sample.SecondarySampling = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+		Sample.bFoundTarget = Response.Target.TargetComponent != nullptr;
+	}
+
+	return Sample;
+}
+
+void ULockOnTargetBenchmarkHandler::SolveBatched(const FFindTargetContext& Context, TArrayView<FTargetContext> TargetsData) const
+{
+	MakeSolverParams(Context).Solve(TargetsData);
+}
+
+float ULockOnTargetBenchmarkHandler::CalculateDefaultTargetWeight(const FFindTargetContext& Context, const FTargetContext& TargetContext) const
+{
+	return CalculateTargetWeight_Implementation(Context, TargetContext);
+}
+
+bool ULockOnTargetBenchmarkHandler::CanUseBatchedSolver() const
+{
+	//The weight calculation isn't overridden, so the batched solver is always valid.
+	return bBatchedSolver;
+}
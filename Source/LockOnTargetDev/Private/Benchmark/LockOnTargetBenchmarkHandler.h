@@ -0,0 +1,58 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TargetHandlers/WeightedTargetHandler.h"
+#include "LockOnTargetBenchmarkHandler.generated.h"
+
+/** Timings of a single FindTarget iteration, in seconds. */
+struct FLockOnTargetBenchmarkSample
+{
+	double PrimarySampling = 0.0;
+	double Solver = 0.0;
+	double Sort = 0.0;
+	double SecondarySampling = 0.0;
+
+	//Targets that passed the primary sampling pass.
+	int32 CandidatesNum = 0;
+
+	//Whether the secondary sampling pass found a Target.
+	bool bFoundTarget = false;
+};
+
+/**
+ * WeightedTargetHandler used by the benchmark commandlet.
+ * Runs the same passes as FindTargetBatched() but times each one separately.
+ * 
+ * Render and screen checks are disabled by default, as nothing is rendered with NullRHI.
+ * Uses the batched solver unless bBatchedSolver is disabled, so both solver paths can be compared.
+ */
+UCLASS(NotBlueprintable, Transient, HideDropdown)
+class ULockOnTargetBenchmarkHandler : public UWeightedTargetHandler
+{
+	GENERATED_BODY()
+
+public:
+
+	ULockOnTargetBenchmarkHandler();
+
+	//Whether to use the batched solver or CalculateTargetWeight() for each Target.
+	bool bBatchedSolver = true;
+
+public:
+
+	/** Performs a single timed FindTarget iteration. */
+	FLockOnTargetBenchmarkSample RunTimedFindTarget();
+
+	/** Calculates weights with the batched solver regardless of bBatchedSolver. */
+	void SolveBatched(const FFindTargetContext& Context, TArrayView<FTargetContext> TargetsData) const;
+
+	/** Calculates the weight with the default CalculateTargetWeight() implementation. */
+	float CalculateDefaultTargetWeight(const FFindTargetContext& Context, const FTargetContext& TargetContext) const;
+
+protected: /** Overrides */
+
+	//UWeightedTargetHandler
+	virtual bool CanUseBatchedSolver() const override;
+};
@@ -0,0 +1,60 @@
+// Copyright 2022-2023 Ivan Baktenkov. All Rights Reserved.
+
+#include "Benchmark/LockOnTargetBenchmarkHandler.h"
+
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLockOnTargetBatchedSolverTest, "LockOnTarget.WeightedTargetHandler.BatchedSolver", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FLockOnTargetBatchedSolverTest::RunTest(const FString& Parameters)
+{
+	ULockOnTargetBenchmarkHandler* const Handler = NewObject<ULockOnTargetBenchmarkHandler>(GetTransientPackage());
+	FRandomStream RandomStream(0);
+
+	//The delta angle factor is the only one approximated. The error is bounded by the acos approximation error (~0.004 deg) scaled into the weight.
+	constexpr float MaxAcosErrorDeg = 0.005f;
+	const float Tolerance = Handler->PureDefaultWeight * (MaxAcosErrorDeg / Handler->DeltaAngleMaxFactor + UE_KINDA_SMALL_NUMBER);
+
+	for (const EFindTargetContextMode Mode : { EFindTargetContextMode::Find, EFindTargetContextMode::Switch })
+	{
+		FFindTargetContext Context;
+		Context.Mode = Mode;
+		Context.SolverViewDirection = RandomStream.GetUnitVector();
+
+		TArray<FTargetContext> TargetsData;
+
+		//Edge cases of the acos domain.
+		TargetsData.AddDefaulted_GetRef().Direction = Context.SolverViewDirection;
+		TargetsData.AddDefaulted_GetRef().Direction = -Context.SolverViewDirection;
+
+		//Not a multiple of 4, so the remainder of the batch is covered as well.
+		for (int32 i = 0; i < 1021; ++i)
+		{
+			FTargetContext& TargetContext = TargetsData.AddDefaulted_GetRef();
+			TargetContext.Direction = RandomStream.GetUnitVector();
+			TargetContext.DistanceSq = FMath::Square(RandomStream.FRandRange(0.f, 1.5f * Handler->DistanceMaxFactor));
+			TargetContext.DeltaAngle2D = RandomStream.FRandRange(0.f, Handler->PlayerInputAngularRange);
+			TargetContext.Priority = RandomStream.FRand();
+		}
+
+		Handler->SolveBatched(Context, TargetsData);
+
+		for (int32 i = 0; i < TargetsData.Num(); ++i)
+		{
+			const float ExpectedWeight = Handler->CalculateDefaultTargetWeight(Context, TargetsData[i]);
+
+			if (!TestEqual(FString::Printf(TEXT("Weight of Target %d in %s mode"), i, *UEnum::GetValueAsString(Mode)), TargetsData[i].Weight, ExpectedWeight, Tolerance))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS